@@ -1,8 +1,51 @@
 import QtQuick
+import QtQuick.Controls
+import Expldy
 
 Window {
-    width: 640
-    height: 480
+    width: 800
+    height: 600
     visible: true
-    title: qsTr("Hello World")
+    title: qsTr("Expldy (Qt Quick)")
+
+    PetStage {
+        id: stage
+        anchors.left: parent.left
+        anchors.top: parent.top
+        anchors.bottom: parent.bottom
+        anchors.right: panel.left
+    }
+
+    // 物品列表：点一下在角色旁边生成一个
+    Rectangle {
+        id: panel
+        width: 160
+        anchors.top: parent.top
+        anchors.bottom: parent.bottom
+        anchors.right: parent.right
+        color: "#f0f0f0"
+
+        ListView {
+            id: list
+            anchors.fill: parent
+            anchors.bottomMargin: clearButton.height
+            clip: true
+            model: stage.catalog
+            delegate: ItemDelegate {
+                required property string modelData
+                width: ListView.view.width
+                text: modelData
+                onClicked: stage.spawn(modelData)
+            }
+        }
+
+        Button {
+            id: clearButton
+            anchors.left: parent.left
+            anchors.right: parent.right
+            anchors.bottom: parent.bottom
+            text: qsTr("Clear")
+            onClicked: stage.clearItems()
+        }
+    }
 }
@@ -0,0 +1,501 @@
+#include "assetstore.h"
+#include "samplecache.h"
+#include "framescaler.h"
+#include "metrics.h"
+#include "frameblend.h"
+#include "itemdb.h"
+#include "interner.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfoList>
+#include <QImage>
+#include <QImageReader>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace
+{
+    // 仓库只持有 weak_ptr：使用者都放手后条目还留在表里，插入新条目时把它们清掉
+    template <typename T>
+    void pruneExpired(QHash<QString, std::weak_ptr<T>> &table)
+    {
+        for (auto it = table.begin(); it != table.end();)
+            it = it.value().expired() ? table.erase(it) : std::next(it);
+    }
+}
+
+Clip::~Clip()
+{
+    AssetStore::instance().releaseFrames(frames);
+}
+
+AssetStore &AssetStore::instance()
+{
+    static AssetStore store;
+    static const bool exported = []()
+    {
+        Metrics &m = Metrics::instance();
+        m.gaugeFn("expldy_pixmap_resident_bytes", "Bytes of decoded frames held by the frame pool", QString(),
+                  []()
+                  { return double(store.residentPixmapBytes()); });
+        m.gaugeFn("expldy_audio_resident_bytes", "Bytes of decoded PCM held by the sample cache", QString(),
+                  []()
+                  { return store.sampleCache ? double(store.sampleCache->residentBytes()) : 0.0; });
+        return true;
+    }();
+    Q_UNUSED(exported);
+    return store;
+}
+
+QString AssetStore::findAssetsRoot()
+{
+    const QString cwd = QDir::currentPath();
+    const QString appDir = QCoreApplication::applicationDirPath();
+
+    const QStringList candidates = {
+        QDir(cwd).filePath("assets"),
+        QDir(appDir).filePath("assets"),
+        QDir(appDir).filePath("../assets"),
+        QDir(appDir).filePath("../../assets"),
+    };
+
+    for (const auto &p : candidates)
+    {
+        if (QDir(p).exists())
+            return p;
+    }
+    return {};
+}
+
+QString AssetStore::clipKey(const QString &dirPath, const QSize &targetSize, int maxFrames)
+{
+    QString key = QString("%1@%2x%3")
+                      .arg(QDir::cleanPath(QDir(dirPath).absolutePath()))
+                      .arg(targetSize.width())
+                      .arg(targetSize.height());
+    if (maxFrames > 0)
+        key += QString("#%1").arg(maxFrames);
+    return key;
+}
+
+ClipHandle AssetStore::clip(const QString &dirPath, const QSize &targetSize, int maxFrames)
+{
+    if (ClipHandle alive = clips.value(clipKey(dirPath, targetSize, maxFrames)).lock())
+        return alive;
+    return adopt(dirPath, targetSize, decode(dirPath, targetSize, maxFrames), maxFrames);
+}
+
+namespace
+{
+    // 单帧：归一化到画布、裁掉透明边，追加到 out
+    void appendFrame(AssetStore::DecodedClip &out, const QImage &raw, const QSize &targetSize, int durationMs)
+    {
+        if (raw.isNull())
+            return;
+        const QImage norm = scaleIntoCanvas(raw, targetSize);
+
+        // 裁掉透明边：只存、只画包围盒内的像素
+        QRect bounds = AssetStore::opaqueBounds(norm);
+        if (bounds.isEmpty())
+            bounds = QRect(0, 0, 1, 1);
+        out.trimSaved += (qint64(norm.width()) * norm.height() - qint64(bounds.width()) * bounds.height()) * 4;
+
+        out.images.push_back(norm.copy(bounds));
+        out.offsets.push_back(bounds.topLeft());
+        out.durations.push_back(std::max(0, durationMs));
+    }
+
+    bool full(const AssetStore::DecodedClip &out, int maxFrames)
+    {
+        return maxFrames > 0 && out.images.size() >= maxFrames;
+    }
+
+    // sheet.json:
+    //   { "image": "sheet.png", "frame_width": 64, "frame_height": 64, "count": 8, "duration_ms": 100 }
+    //   { "image": "sheet.png", "frames": [ { "x": 0, "y": 0, "w": 64, "h": 64, "duration_ms": 120 }, ... ] }
+    // 格子按行优先切；count 省略时切满整张图
+    void decodeSheet(AssetStore::DecodedClip &out, const QDir &dir, const QSize &targetSize, int maxFrames)
+    {
+        QFile f(dir.filePath("sheet.json"));
+        if (!f.open(QIODevice::ReadOnly))
+            return;
+        const QJsonObject o = QJsonDocument::fromJson(f.readAll()).object();
+        const QImage sheet(dir.filePath(o.value("image").toString("sheet.png")));
+        if (sheet.isNull())
+        {
+            qWarning() << "AssetStore: sprite sheet image missing in" << dir.path();
+            return;
+        }
+        const int defaultMs = o.value("duration_ms").toInt(0);
+
+        if (o.value("frames").isArray())
+        {
+            const QJsonArray frames = o.value("frames").toArray();
+            for (const auto &v : frames)
+            {
+                if (full(out, maxFrames))
+                    break;
+                const QJsonObject fr = v.toObject();
+                const QRect r(fr.value("x").toInt(), fr.value("y").toInt(), fr.value("w").toInt(), fr.value("h").toInt());
+                if (r.isEmpty() || !sheet.rect().contains(r))
+                    continue;
+                appendFrame(out, sheet.copy(r), targetSize, fr.value("duration_ms").toInt(defaultMs));
+            }
+            return;
+        }
+
+        const int fw = o.value("frame_width").toInt();
+        const int fh = o.value("frame_height").toInt();
+        if (fw <= 0 || fh <= 0)
+            return;
+        const int cols = sheet.width() / fw;
+        const int rows = sheet.height() / fh;
+        const int count = std::min(o.value("count").toInt(cols * rows), cols * rows);
+        for (int i = 0; i < count && !full(out, maxFrames); ++i)
+            appendFrame(out, sheet.copy((i % cols) * fw, (i / cols) * fh, fw, fh), targetSize, defaultMs);
+    }
+
+    // 动画容器：QImageReader 每次 read() 只解码下一帧，文件从头到尾顺序读一遍
+    void decodeAnimated(AssetStore::DecodedClip &out, const QString &path, const QSize &targetSize, int maxFrames)
+    {
+        constexpr int kMaxFrames = 1024; // 防御：坏文件不无限读
+        QImageReader reader(path);
+        QImage raw;
+        while (!full(out, maxFrames) && out.images.size() < kMaxFrames && reader.read(&raw))
+        {
+            // nextImageDelay() 是刚读出的这一帧要停留的时长
+            appendFrame(out, raw, targetSize, reader.nextImageDelay());
+            if (!reader.supportsAnimation())
+                break;
+        }
+        if (out.images.isEmpty())
+            qWarning() << "AssetStore: cannot decode" << path << reader.errorString();
+    }
+}
+
+int frameAtTime(const SpriteFrames &frames, qint64 elapsedMs, int defaultMs)
+{
+    const int n = frames.size();
+    if (n == 0)
+        return 0;
+    qint64 total = 0;
+    for (int i = 0; i < n; ++i)
+        total += frameDuration(frames, i, defaultMs);
+    if (total <= 0)
+        return 0;
+    qint64 t = elapsedMs % total;
+    for (int i = 0; i < n; ++i)
+    {
+        t -= frameDuration(frames, i, defaultMs);
+        if (t < 0)
+            return i;
+    }
+    return n - 1;
+}
+
+AssetStore::DecodedClip AssetStore::decode(const QString &dirPath, const QSize &targetSize, int maxFrames)
+{
+    DecodedClip out;
+    QDir dir(dirPath);
+    if (!dir.exists())
+        return out;
+
+    if (dir.exists("sheet.json"))
+    {
+        decodeSheet(out, dir, targetSize, maxFrames);
+        if (!out.images.isEmpty())
+            return out;
+    }
+
+    const QFileInfoList anims = dir.entryInfoList({"*.webp", "*.WEBP", "*.apng", "*.APNG", "*.gif", "*.GIF"},
+                                                  QDir::Files, QDir::Name);
+    if (!anims.isEmpty())
+    {
+        decodeAnimated(out, anims.first().absoluteFilePath(), targetSize, maxFrames);
+        if (!out.images.isEmpty())
+            return out;
+    }
+
+    const QFileInfoList files = dir.entryInfoList({"*.png", "*.PNG"}, QDir::Files, QDir::Name);
+    for (const auto &fi : files)
+    {
+        if (full(out, maxFrames))
+            break;
+        appendFrame(out, QImage(fi.absoluteFilePath()), targetSize, 0);
+    }
+    return out;
+}
+
+ClipHandle AssetStore::adopt(const QString &dirPath, const QSize &targetSize, const DecodedClip &decoded, int maxFrames)
+{
+    const QString key = clipKey(dirPath, targetSize, maxFrames);
+    if (ClipHandle alive = clips.value(key).lock())
+        return alive;
+
+    auto c = std::make_shared<Clip>();
+    c->canvas = targetSize;
+    trimSaved += decoded.trimSaved;
+    for (int i = 0; i < decoded.images.size(); ++i)
+    {
+        const int id = internFrame(decoded.images[i]);
+        if (id < 0)
+            continue;
+
+        SpriteFrame f;
+        f.pixmap = pool[id].pixmap;
+        f.offset = decoded.offsets[i];
+        f.id = id;
+        f.durationMs = decoded.durations.value(i);
+        c->frames.push_back(f);
+    }
+    if (c->frames.isEmpty())
+        return nullptr;
+
+    ClipHandle handle = std::move(c);
+    if (clips.size() >= clipsPruneAt)
+    {
+        pruneExpired(clips);
+        clipsPruneAt = std::max(64, int(clips.size()) * 2);
+    }
+    clips.insert(key, handle);
+    return handle;
+}
+
+std::shared_ptr<ItemDB> AssetStore::itemDB(const QString &assetsRoot, const QSize &targetSize)
+{
+    const QString key = clipKey(QDir(assetsRoot).filePath("items"), targetSize, -1);
+    if (std::shared_ptr<ItemDB> alive = itemDBs.value(key).lock())
+        return alive;
+
+    auto db = std::make_shared<ItemDB>();
+    db->loadAsync(assetsRoot, targetSize);
+    pruneExpired(itemDBs);
+    itemDBs.insert(key, db);
+    return db;
+}
+
+namespace
+{
+    QStringList scanAudioFiles(const QString &dirPath)
+    {
+        QStringList out;
+        const QFileInfoList files = QDir(dirPath).entryInfoList(
+            {"*.wav", "*.WAV", "*.ogg", "*.OGG", "*.mp3", "*.MP3"},
+            QDir::Files, QDir::Name);
+        for (const auto &fi : files)
+            out << fi.absoluteFilePath();
+        return out;
+    }
+
+    // 每个子目录就是一个 category
+    QVector<QStringList> scanAudioBank(const QString &baseDir)
+    {
+        QVector<QStringList> bank;
+        const QFileInfoList dirs = QDir(baseDir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const auto &d : dirs)
+        {
+            const QStringList files = scanAudioFiles(d.absoluteFilePath());
+            if (files.isEmpty())
+                continue;
+
+            const int category = audioCategoryTable().intern(d.fileName());
+            if (category >= bank.size())
+                bank.resize(category + 1);
+            bank[category] = files;
+        }
+        return bank;
+    }
+}
+
+AudioBanksPtr AssetStore::audioBanks(const QString &assetsRoot)
+{
+    const QString key = QDir::cleanPath(QDir(assetsRoot).absolutePath());
+    // 扫描也在锁里：几个音频线程同时启动时只有第一个扫，其余等它的结果
+    QMutexLocker lock(&banksMutex);
+    if (AudioBanksPtr alive = banks.value(key).lock())
+        return alive;
+
+    auto b = std::make_shared<AudioBanks>();
+    const QDir audioBase(QDir(key).filePath("audio"));
+    b->channel[0] = scanAudioBank(audioBase.filePath("wife"));
+    b->channel[1] = scanAudioBank(audioBase.filePath("items"));
+    b->channel[2] = scanAudioBank(audioBase.filePath("monsters"));
+
+    AudioBanksPtr handle = std::move(b);
+    pruneExpired(banks);
+    banks.insert(key, handle);
+    return handle;
+}
+
+int AssetStore::internFrame(const QImage &img)
+{
+    if (img.isNull())
+        return -1;
+
+    // 尺寸 + 像素内容的 SHA-1 作为地址
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    const int w = img.width();
+    const int hgt = img.height();
+    h.addData(QByteArrayView(reinterpret_cast<const char *>(&w), sizeof(w)));
+    h.addData(QByteArrayView(reinterpret_cast<const char *>(&hgt), sizeof(hgt)));
+    for (int y = 0; y < hgt; ++y)
+        h.addData(QByteArrayView(reinterpret_cast<const char *>(img.constScanLine(y)), qsizetype(w) * 4));
+    const QByteArray digest = h.result();
+
+    ++framesLoaded;
+    auto it = poolByDigest.constFind(digest);
+    if (it != poolByDigest.constEnd())
+    {
+        ++framesShared;
+        bytesSaved += qint64(w) * hgt * 4;
+        ++pool[it.value()].refs;
+        return it.value();
+    }
+
+    int id;
+    if (!freeSlots.isEmpty())
+    {
+        id = freeSlots.takeLast();
+    }
+    else
+    {
+        id = pool.size();
+        pool.push_back(PoolEntry());
+    }
+    pool[id].pixmap = QPixmap::fromImage(img);
+    pool[id].digest = digest;
+    pool[id].refs = 1;
+    residentBytes += qint64(w) * hgt * 4;
+    poolByDigest.insert(digest, id);
+    return id;
+}
+
+QRect AssetStore::opaqueBounds(const QImage &img)
+{
+    // premultiplied ARGB32：按 32 位读像素，alpha 在最高字节
+    int top = img.height(), bottom = -1, left = img.width(), right = -1;
+    for (int y = 0; y < img.height(); ++y)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+        int x0 = 0;
+        while (x0 < img.width() && qAlpha(line[x0]) == 0)
+            ++x0;
+        if (x0 == img.width())
+            continue;
+        int x1 = img.width() - 1;
+        while (x1 > x0 && qAlpha(line[x1]) == 0)
+            --x1;
+
+        top = std::min(top, y);
+        bottom = y;
+        left = std::min(left, x0);
+        right = std::max(right, x1);
+    }
+    if (bottom < 0)
+        return QRect();
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void AssetStore::releaseFrames(const SpriteFrames &frames)
+{
+    for (const auto &f : frames)
+    {
+        const int id = f.id;
+        if (id < 0 || id >= pool.size() || --pool[id].refs > 0)
+            continue;
+        poolByDigest.remove(pool[id].digest);
+        dropFadesFor(id); // 下标会被复用，按下标缓存的淡化帧必须作废
+        residentBytes -= qint64(pool[id].pixmap.width()) * pool[id].pixmap.height() * 4;
+        pool[id] = PoolEntry();
+        freeSlots.push_back(id);
+    }
+}
+
+QString AssetStore::poolReport() const
+{
+    const int unique = int(pool.size() - freeSlots.size());
+    return QString("frames loaded=%1 unique=%2 resident=%3 KB trim saved=%4 KB dedup saved=%5 KB")
+        .arg(framesLoaded)
+        .arg(unique)
+        .arg(residentBytes / 1024)
+        .arg(trimSaved / 1024)
+        .arg(bytesSaved / 1024);
+}
+
+SampleCache &AssetStore::samples()
+{
+    if (!sampleCache)
+        sampleCache = new SampleCache(QCoreApplication::instance());
+    return *sampleCache;
+}
+
+SpriteFrames AssetStore::crossfade(const SpriteFrame &from, const SpriteFrame &to, int steps)
+{
+    // 中途被打断的淡化（from 本身是中间帧）不缓存
+    if (from.id < 0 || to.id < 0)
+        return renderCrossfade(from, to, steps);
+
+    const quint64 key = (quint64(quint32(from.id)) << 32) | quint32(to.id);
+    auto it = fades.find(key);
+    if (it != fades.end() && it->steps == steps)
+    {
+        it->lastUse = ++fadeClock;
+        return it->frames;
+    }
+
+    FadeEntry e;
+    e.frames = renderCrossfade(from, to, steps);
+    e.steps = steps;
+    e.lastUse = ++fadeClock;
+    for (const auto &f : e.frames)
+        e.bytes += qint64(f.pixmap.width()) * f.pixmap.height() * 4;
+
+    if (it != fades.end())
+    {
+        fadeBytes -= it->bytes;
+        fades.erase(it);
+    }
+    if (e.bytes > crossfadeBudgetBytes)
+        return e.frames; // 单项就超预算：只用这一次
+
+    // LRU：条目很少（状态对 x 帧），线性找最旧的即可
+    while (fadeBytes + e.bytes > crossfadeBudgetBytes && !fades.isEmpty())
+    {
+        auto oldest = fades.begin();
+        for (auto j = fades.begin(); j != fades.end(); ++j)
+            if (j->lastUse < oldest->lastUse)
+                oldest = j;
+        fadeBytes -= oldest->bytes;
+        fades.erase(oldest);
+    }
+
+    fadeBytes += e.bytes;
+    const SpriteFrames frames = e.frames;
+    fades.insert(key, std::move(e));
+    return frames;
+}
+
+void AssetStore::dropFadesFor(int frameId)
+{
+    for (auto it = fades.begin(); it != fades.end();)
+    {
+        const int a = int(it.key() >> 32);
+        const int b = int(it.key() & 0xffffffffu);
+        if (a == frameId || b == frameId)
+        {
+            fadeBytes -= it->bytes;
+            it = fades.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
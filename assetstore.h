@@ -0,0 +1,161 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QPixmap>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QHash>
+#include <QSize>
+#include <QPointer>
+#include <QByteArray>
+#include <QStringList>
+#include <QMutex>
+#include <memory>
+
+class SampleCache;
+class ItemDB;
+
+// 一帧：归一化后裁到不透明包围盒，offset 是它在画布（targetSize）里的左上角。
+// 绘制 = 在 offset 处 blit pixmap，视觉位置和未裁剪时完全一致。
+struct SpriteFrame
+{
+    QPixmap pixmap;
+    QPoint offset;
+    int id = -1;        // 帧池下标（相同内容的帧下标相同）
+    int durationMs = 0; // 容器（APNG/WebP/GIF/sprite sheet）给的帧时长；0 = 按播放方的默认间隔
+
+    QRect rect() const { return QRect(offset, pixmap.size()); }
+};
+using SpriteFrames = QVector<SpriteFrame>;
+
+// 帧 i 的时长：有容器时长用它，否则用 defaultMs
+inline int frameDuration(const SpriteFrames &frames, int i, int defaultMs)
+{
+    const int d = frames[i].durationMs;
+    return d > 0 ? d : defaultMs;
+}
+
+// 从开头循环播放了 elapsedMs 之后应显示的帧下标（按各帧时长累加）
+int frameAtTime(const SpriteFrames &frames, qint64 elapsedMs, int defaultMs);
+
+// 一个动画片段，加载后不可变。像素只存在 AssetStore 的帧池里，frames 与池隐式共享。
+struct Clip
+{
+    QSize canvas; // 归一化画布尺寸，控件按它定大小、按它算挂点
+    SpriteFrames frames;
+
+    ~Clip(); // 归还帧池引用
+};
+using ClipHandle = std::shared_ptr<const Clip>;
+
+// 一个 assets 目录的音频索引：channel[通道][category 句柄] -> 文件列表（没有文件的 category 为空列表）。
+// 通道顺序与 AudioManager::Channel 一致。构建后不可变
+struct AudioBanks
+{
+    static constexpr int kChannels = 3; // Voice / Sfx / Enemy
+    QVector<QStringList> channel[kChannels];
+};
+using AudioBanksPtr = std::shared_ptr<const AudioBanks>;
+
+// AssetStore
+// 进程级资源仓库：同一个 (目录, targetSize) 只解码一次，多个 WifeLabel / ItemDB / InventoryDialog 共享。
+// 仓库自己只持有 weak_ptr，最后一个使用者释放句柄后帧内存随之释放；过期的条目在插入新条目时顺带清掉。
+// 物品库（ItemDB）和音频 bank 也按 assets 目录在这里共用，多个角色不再各扫一遍、各建一份。
+// 音频侧的 SampleCache 也放在这里，所有 AudioManager 共用一个解码线程和字节预算。
+class AssetStore
+{
+public:
+    static AssetStore &instance();
+
+    // assets 目录：依次找工作目录、可执行文件目录及其上两级，找不到返回空
+    static QString findAssetsRoot();
+
+    // 一个 clip 目录按以下顺序识别，目录不存在或没有帧时返回空句柄：
+    // 1) sheet.json + 一张 sprite sheet（格子切分或逐帧矩形，可带每帧时长）
+    // 2) 单个动画文件 *.webp / *.apng / *.gif：一次顺序读取逐帧解码，帧时长取自容器
+    //    （APNG 需要 Qt 装有支持它的图片插件，否则只得到第一帧）
+    // 3) 目录下的 *.png 按文件名排序作为帧
+    // maxFrames > 0 时只解码前几帧（启动时先出第一帧），与完整 clip 分开缓存，像素照样进帧池去重
+    ClipHandle clip(const QString &dirPath, const QSize &targetSize, int maxFrames = -1);
+
+    // clip() 拆成两半，给后台加载用：
+    // - decode() 只读文件、归一化、裁边，不碰 QPixmap 和帧池，任意线程可调用
+    // - adopt() 在 GUI 线程把结果放进帧池；同 key 的 clip 已在用时直接返回它
+    struct DecodedClip
+    {
+        QVector<QImage> images; // 已裁到不透明包围盒
+        QVector<QPoint> offsets;
+        QVector<int> durations; // 毫秒，0 = 未指定
+        qint64 trimSaved = 0;
+    };
+    static DecodedClip decode(const QString &dirPath, const QSize &targetSize, int maxFrames = -1);
+    ClipHandle adopt(const QString &dirPath, const QSize &targetSize, const DecodedClip &decoded, int maxFrames = -1);
+
+    SampleCache &samples();
+
+    // 物品库（GUI 线程）：同一个 (assets 目录, 物品尺寸) 共用一个 ItemDB，第一次取时开始后台加载。
+    // 用 ItemDB::whenReady() 等它发布
+    std::shared_ptr<ItemDB> itemDB(const QString &assetsRoot, const QSize &targetSize);
+
+    // 音频 bank（任何线程，音频线程在用）：同一个 assets 目录只扫描一次，所有 AudioManager 共用
+    AudioBanksPtr audioBanks(const QString &assetsRoot);
+
+    // 内容寻址帧池：归一化后的帧按像素内容哈希，相同内容（重复帧、往返帧、
+    // 多个 clip 共用的首帧、多个物品共用的贴图）只存一份
+    const QPixmap &poolFrame(int id) const { return pool[id].pixmap; }
+    QString poolReport() const; // 一行统计：帧数 / 去重后 / 裁边与去重各节省的字节
+    qint64 residentPixmapBytes() const { return residentBytes; }
+
+    // from -> to 的交叉淡化中间帧（frameblend.h）。两端都是池里的帧时按 (from.id, to.id, steps) 缓存，
+    // LRU，总量不超过 crossfadeBudgetBytes；帧被释放时相关缓存一并作废
+    SpriteFrames crossfade(const SpriteFrame &from, const SpriteFrame &to, int steps);
+    qint64 crossfadeBudgetBytes = 8 * 1024 * 1024;
+
+    // 不透明像素（alpha != 0）的包围盒；全透明返回空矩形
+    static QRect opaqueBounds(const QImage &img);
+
+private:
+    AssetStore() = default;
+
+    QHash<QString, std::weak_ptr<const Clip>> clips; // key: 规范化路径 + 尺寸
+    int clipsPruneAt = 64;                           // clips 长到这么多时清一次过期条目（摊还 O(1)）
+    QHash<QString, std::weak_ptr<ItemDB>> itemDBs;   // key 同上（items 目录 + 物品尺寸）
+
+    QMutex banksMutex; // audioBanks 在各个音频线程调用
+    QHash<QString, std::weak_ptr<const AudioBanks>> banks; // key: 规范化的 assets 目录
+
+    struct PoolEntry
+    {
+        QPixmap pixmap;
+        QByteArray digest;
+        int refs = 0;
+    };
+    QVector<PoolEntry> pool;
+    QVector<int> freeSlots;
+    QHash<QByteArray, int> poolByDigest;
+    qint64 framesLoaded = 0;
+    qint64 framesShared = 0;
+    qint64 bytesSaved = 0;
+    qint64 trimSaved = 0;
+    qint64 residentBytes = 0; // 池里仍被引用的帧像素字节（按 ARGB32 算）
+
+    struct FadeEntry
+    {
+        SpriteFrames frames;
+        int steps = 0;
+        qint64 bytes = 0;
+        quint64 lastUse = 0;
+    };
+    QHash<quint64, FadeEntry> fades; // key: (from.id << 32) | to.id
+    qint64 fadeBytes = 0;
+    quint64 fadeClock = 0;
+    void dropFadesFor(int frameId);
+
+    int internFrame(const QImage &img);
+    void releaseFrames(const SpriteFrames &frames);
+    friend struct Clip;
+    QPointer<SampleCache> sampleCache;               // 挂在 qApp 上，随应用退出释放
+
+    static QString clipKey(const QString &dirPath, const QSize &targetSize, int maxFrames);
+};
@@ -1,123 +1,346 @@
 #include "audiomanager.h"
+#include "interner.h"
+#include "assetstore.h"
 
-#include <QDir>
-#include <QFileInfoList>
 #include <QRandomGenerator>
 #include <QUrl>
 #include <algorithm>
 
-AudioManager::AudioManager(QObject *parent) : QObject(parent)
+static_assert(AudioBanks::kChannels == AudioManager::ChannelCount, "AudioBanks channels follow AudioManager::Channel");
+
+AudioManager::AudioManager(QObject *parent)
+    : QObject(parent)
 {
-    voicePlayer.setAudioOutput(&voiceOut);
-    sfxPlayer.setAudioOutput(&sfxOut);
-    enemyPlayer.setAudioOutput(&enemyOut);
+    dropped = &Metrics::instance().counter("expldy_audio_commands_dropped_total",
+                                           "Audio commands dropped because the audio thread queue was full");
+
+    engine = new AudioEngine(queue, AssetStore::instance().samples());
+    engine->moveToThread(&thread);
+    connect(&thread, &QThread::finished, engine, &QObject::deleteLater);
+    thread.setObjectName("Audio");
+    thread.start(QThread::HighPriority);
 
-    setVolume01(volume01);
+    AudioEngine *e = engine;
+    QMetaObject::invokeMethod(e, [e]()
+                              { e->init(); }, Qt::QueuedConnection);
 }
 
-void AudioManager::setVolume01(double v01)
+AudioManager::~AudioManager()
 {
-    volume01 = std::clamp(v01, 0.0, 1.0);
+    // 引擎在线程结束时删除（它的析构先停掉 sink）；队列是本对象的成员，要等线程完全退出
+    thread.quit();
+    thread.wait();
+}
+
+void AudioManager::push(const AudioCommand &cmd)
+{
+    if (!queue.ring.push(cmd))
+    {
+        dropped->fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    wake();
+}
+
+void AudioManager::wake()
+{
+    // 音频线程清标记后才开始取命令：要么它这一轮能看到这条，要么这里会再投递一次
+    if (!queue.wakePending.exchange(true))
+    {
+        AudioEngine *e = engine;
+        QMetaObject::invokeMethod(e, [e]()
+                                  { e->drain(); }, Qt::QueuedConnection);
+    }
+}
 
-    // UI 0.0-1.0 映射到 0.0-2.0 的软件增益（和你之前一致）
-    const double boosted = std::clamp(volume01 * 2.0, 0.0, 2.0);
-    voiceOut.setVolume(float(boosted));
-    sfxOut.setVolume(float(boosted));
-    enemyOut.setVolume(float(boosted));
+void AudioManager::setVolume01(double v01)
+{
+    // 只留最新值：连续拖滑块时音频线程只应用最后一次
+    queue.volume.store(float(std::clamp(v01, 0.0, 1.0)), std::memory_order_release);
+    wake();
 }
 
 void AudioManager::setAssetsRoot(const QString &assetsRoot)
 {
-    root = assetsRoot;
+    QMutexLocker lock(&queue.rootMutex);
+    queue.root = assetsRoot;
 }
 
-QStringList AudioManager::scanAudioFiles(const QString &dirPath) const
+void AudioManager::rebuildIndex()
 {
-    QStringList out;
-    QDir dir(dirPath);
-    if (!dir.exists())
-        return out;
+    queue.rescanPending.store(true, std::memory_order_release);
+    wake();
+}
 
-    const QFileInfoList files = dir.entryInfoList(
-        {"*.wav", "*.WAV", "*.ogg", "*.OGG", "*.mp3", "*.MP3"},
-        QDir::Files, QDir::Name);
+void AudioManager::stop()
+{
+    AudioCommand cmd;
+    cmd.op = AudioCommand::Op::Stop;
+    cmd.channel = AudioCommand::kAllChannels;
+    push(cmd);
+}
 
-    for (const auto &fi : files)
-        out << fi.absoluteFilePath();
+void AudioManager::playVoice(int category)
+{
+    if (category >= 0)
+        push({AudioCommand::Op::Play, Voice, category});
+}
 
-    return out;
+void AudioManager::playSfx(int category)
+{
+    if (category >= 0)
+        push({AudioCommand::Op::Play, Sfx, category});
 }
 
-void AudioManager::rebuildBankFromDir(QHash<QString, QStringList> &outBank, const QString &baseDir)
+void AudioManager::playEnemy(int category)
 {
-    outBank.clear();
-    QDir base(baseDir);
-    if (!base.exists())
-        return;
+    if (category >= 0)
+        push({AudioCommand::Op::Play, Enemy, category});
+}
 
-    // 每个子目录就是一个 category
-    const QFileInfoList dirs = base.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-    for (const auto &d : dirs)
+void AudioManager::playVoice(const QString &category)
+{
+    playVoice(audioCategoryTable().find(category));
+}
+
+void AudioManager::playSfx(const QString &category)
+{
+    playSfx(audioCategoryTable().find(category));
+}
+
+void AudioManager::playEnemy(const QString &category)
+{
+    playEnemy(audioCategoryTable().find(category));
+}
+
+void AudioManager::prefetchVoice(int category)
+{
+    if (category >= 0)
+        push({AudioCommand::Op::Prefetch, Voice, category});
+}
+
+void AudioManager::prefetchSfx(int category)
+{
+    if (category >= 0)
+        push({AudioCommand::Op::Prefetch, Sfx, category});
+}
+
+void AudioManager::prefetchEnemy(int category)
+{
+    if (category >= 0)
+        push({AudioCommand::Op::Prefetch, Enemy, category});
+}
+
+void AudioManager::playRandom(const QString &category)
+{
+    // 兼容旧调用：默认走 Voice
+    playVoice(category);
+}
+
+AudioEngine::AudioEngine(AudioCommandQueue &q, SampleCache &c)
+    : queue(q), cache(c)
+{
+}
+
+AudioEngine::~AudioEngine()
+{
+    // sink 在读 Channel::buffer，必须先于成员析构停掉
+    for (auto &ch : channels)
     {
-        const QString category = d.fileName();
-        const QStringList files = scanAudioFiles(d.absoluteFilePath());
-        if (!files.isEmpty())
-            outBank.insert(category, files);
+        if (!ch)
+            continue;
+        stopChannel(*ch);
+        delete ch->sink;
+        ch->sink = nullptr;
     }
 }
 
-void AudioManager::rebuildIndex()
+void AudioEngine::init()
 {
-    voiceBank.clear();
-    sfxBank.clear();
-    enemyBank.clear();
-    if (root.isEmpty())
+    if (channels[0])
         return;
 
-    const QString audioBase = QDir(root).filePath("audio");
-    rebuildBankFromDir(voiceBank, QDir(audioBase).filePath("wife"));
-    rebuildBankFromDir(sfxBank, QDir(audioBase).filePath("items"));
-    rebuildBankFromDir(enemyBank, QDir(audioBase).filePath("monsters"));
+    Metrics &m = Metrics::instance();
+    const char *names[AudioManager::ChannelCount] = {"voice", "sfx", "enemy"};
+    for (int i = 0; i < AudioManager::ChannelCount; ++i)
+    {
+        channels[i] = std::make_unique<Channel>();
+        Channel *ch = channels[i].get();
+        ch->player.setAudioOutput(&ch->out);
+
+        const QString label = QString(R"(channel="%1")").arg(names[i]);
+        ch->plays = &m.counter("expldy_audio_plays_total", "Audio clips started per channel", label);
+        ch->failures = &m.counter("expldy_audio_failures_total", "Audio files that failed to decode or play",
+                                  QString(R"(stage="play",%1)").arg(label));
+        Metrics::Value *failures = ch->failures;
+        connect(&ch->player, &QMediaPlayer::errorOccurred, this, [failures](QMediaPlayer::Error err)
+                {
+            if (err != QMediaPlayer::NoError)
+                failures->fetch_add(1, std::memory_order_relaxed); });
+    }
+
+    devices = new QMediaDevices(this);
+    output = QMediaDevices::defaultAudioOutput();
+    connect(devices, &QMediaDevices::audioOutputsChanged, this, [this]()
+            {
+        output = QMediaDevices::defaultAudioOutput();
+        // 旧 sink 绑在旧设备上：下次播放时按新设备重建
+        for (auto &ch : channels)
+        {
+            if (!ch || !ch->sink)
+                continue;
+            stopChannel(*ch);
+            delete ch->sink;
+            ch->sink = nullptr;
+        } });
+
+    applyVolume(volume01);
 }
 
-void AudioManager::stop()
+void AudioEngine::drain()
 {
-    voicePlayer.stop();
-    sfxPlayer.stop();
-    enemyPlayer.stop();
+    // 先清标记再取：清之后入队的命令会重新投递一次 drain
+    queue.wakePending.store(false);
+    if (!channels[0]) // init 还没跑（它先于任何 drain 投递，这里只是兜底）
+        init();
+
+    // 配置在每条命令前检查：命令是在配置之后入队的，取到它时配置一定已经可见
+    applyConfig();
+    AudioCommand cmd;
+    while (queue.ring.pop(cmd))
+    {
+        applyConfig();
+        execute(cmd);
+    }
 }
 
-void AudioManager::playFromBank(QMediaPlayer &p, const QHash<QString, QStringList> &bank, const QString &category)
+void AudioEngine::applyConfig()
 {
-    const auto list = bank.value(category);
-    if (list.isEmpty())
-        return;
+    if (queue.rescanPending.load(std::memory_order_acquire) && queue.rescanPending.exchange(false))
+        rebuildIndex();
 
-    const int idx = QRandomGenerator::global()->bounded(list.size());
-    const QString path = list.at(idx);
+    if (queue.volume.load(std::memory_order_acquire) >= 0.f)
+    {
+        const float v = queue.volume.exchange(-1.f);
+        if (v >= 0.f)
+            applyVolume(v);
+    }
+}
 
-    p.stop();
-    p.setSource(QUrl::fromLocalFile(path));
-    p.play();
+void AudioEngine::execute(const AudioCommand &cmd)
+{
+    switch (cmd.op)
+    {
+    case AudioCommand::Op::Play:
+        if (cmd.channel < AudioManager::ChannelCount && channels[cmd.channel])
+            playFromBank(*channels[cmd.channel], bankFor(cmd.channel), cmd.category);
+        break;
+    case AudioCommand::Op::Prefetch:
+        if (cmd.channel < AudioManager::ChannelCount)
+            prefetchFromBank(bankFor(cmd.channel), cmd.category);
+        break;
+    case AudioCommand::Op::Stop:
+        for (int i = 0; i < AudioManager::ChannelCount; ++i)
+        {
+            if (channels[i] && (cmd.channel == AudioCommand::kAllChannels || cmd.channel == i))
+                stopChannel(*channels[i]);
+        }
+        break;
+    }
 }
 
-void AudioManager::playVoice(const QString &category)
+void AudioEngine::applyVolume(double v01)
 {
-    playFromBank(voicePlayer, voiceBank, category);
+    volume01 = std::clamp(v01, 0.0, 1.0);
+
+    // 解码缓存命中（QAudioSink）和回退读盘（QMediaPlayer）用同一个增益：同一段音效两条路径一样响
+    const double g = gain();
+    for (auto &ch : channels)
+    {
+        if (!ch)
+            continue;
+        ch->out.setVolume(float(g));
+        if (ch->sink)
+            ch->sink->setVolume(g);
+    }
 }
 
-void AudioManager::playSfx(const QString &category)
+double AudioEngine::gain() const
 {
-    playFromBank(sfxPlayer, sfxBank, category);
+    // 以前把滑块乘 2 再截到 1.0：上半段滑块没有作用。对数刻度让整段滑块都有听感上均匀的变化
+    return QAudio::convertVolume(volume01, QAudio::LogarithmicVolumeScale, QAudio::LinearVolumeScale);
 }
 
-void AudioManager::playEnemy(const QString &category)
+const AudioEngine::Bank &AudioEngine::bankFor(int channel) const
 {
-    playFromBank(enemyPlayer, enemyBank, category);
+    static const Bank empty;
+    return banks ? banks->channel[channel] : empty;
 }
 
-void AudioManager::playRandom(const QString &category)
+void AudioEngine::rebuildIndex()
 {
-    // 兼容旧调用：默认走 Voice
-    playVoice(category);
+    QString root;
+    {
+        QMutexLocker lock(&queue.rootMutex);
+        root = queue.root;
+    }
+    banks = root.isEmpty() ? nullptr : AssetStore::instance().audioBanks(root);
+}
+
+void AudioEngine::stopChannel(Channel &ch)
+{
+    ch.player.stop();
+    if (ch.sink)
+        ch.sink->stop();
+    ch.buffer.close();
+    ch.playing.reset();
+}
+
+void AudioEngine::prefetchFromBank(const Bank &bank, int category)
+{
+    if (category < 0 || category >= bank.size())
+        return;
+    cache.prefetch(bank[category]);
+}
+
+void AudioEngine::playFromBank(Channel &ch, const Bank &bank, int category)
+{
+    if (category < 0 || category >= bank.size())
+        return;
+    const QStringList &list = bank[category];
+    if (list.isEmpty())
+        return;
+
+    const int idx = QRandomGenerator::global()->bounded(list.size());
+    const QString &path = list.at(idx);
+
+    stopChannel(ch);
+
+    // 设备不支持解码出来的格式时不建 sink（会静音失败），改走 QMediaPlayer（它自己转换格式）
+    PcmSamplePtr pcm = cache.get(path);
+    if (pcm && !output.isNull() && output.isFormatSupported(pcm->format))
+    {
+        if (!ch.sink || ch.sink->format() != pcm->format)
+        {
+            delete ch.sink;
+            ch.sink = new QAudioSink(output, pcm->format, this);
+            ch.sink->setVolume(gain());
+        }
+        ch.playing = pcm;
+        ch.buffer.setData(pcm->data); // 隐式共享，不拷贝
+        ch.buffer.open(QIODevice::ReadOnly);
+        ch.sink->start(&ch.buffer);
+        if (ch.sink->error() != QAudio::NoError)
+            ch.failures->fetch_add(1, std::memory_order_relaxed);
+        else
+            ch.plays->fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // 未命中：这次读盘播放，同时整类丢给后台解码，下次就走内存
+    if (!pcm)
+        cache.prefetch(list);
+    ch.player.setSource(QUrl::fromLocalFile(path));
+    ch.player.play();
+    ch.plays->fetch_add(1, std::memory_order_relaxed);
 }
@@ -1,24 +1,86 @@
 #pragma once
 #include <QObject>
-#include <QHash>
+#include <QThread>
+#include <QVector>
 #include <QStringList>
 
 #include <QMediaPlayer>
 #include <QAudioOutput>
+#include <QAudioSink>
+#include <QAudioDevice>
+#include <QMediaDevices>
+#include <QBuffer>
+#include <QMutex>
+
+#include <atomic>
+#include <memory>
+
+#include "samplecache.h"
+#include "assetstore.h"
+#include "metrics.h"
+#include "spscring.h"
+
+// 一条音频命令：GUI 线程写入环形队列，音频线程取出执行。只有定长字段，入队就是一次拷贝。
+// 队列满时会丢，所以这里只有丢了也无妨的播放类命令；配置（音量、重建索引）走 AudioCommandQueue 的原子字段
+struct AudioCommand
+{
+    enum class Op : quint8
+    {
+        Play,
+        Prefetch,
+        Stop // channel == kAllChannels 时停全部
+    };
+    static constexpr quint8 kAllChannels = 0xff;
+
+    Op op = Op::Play;
+    quint8 channel = 0; // AudioManager::Channel 下标
+    qint32 category = -1;
+};
+
+// 两个线程共用的命令通道：队列 + “已经投递过唤醒”标记（一批命令只投递一次事件）。
+// 配置是状态不是命令，不会因为队列满而丢：GUI 线程只改下面的原子字段再唤醒，
+// 音频线程每执行一条命令前先应用它们——先设配置、后入队的 play 一定看到新配置。
+// 资源目录不是定长字段，放在旁边由一把锁保护；只有重建索引时读它（不频繁）
+struct AudioCommandQueue
+{
+    SpscRing<AudioCommand, 256> ring;
+    std::atomic<bool> wakePending{false};
+
+    std::atomic<bool> rescanPending{false}; // 按 root 重新取 bank
+    std::atomic<float> volume{-1.f};        // 最新的音量 0.0-1.0；< 0 表示没有未应用的新值
+
+    QMutex rootMutex;
+    QString root;
+};
+
+class AudioEngine;
 
 // AudioManager
 // - Voice: 角色发声（assets/audio/wife/<category>/）
 // - SFX:   物品音效（assets/audio/items/<category>/）
 // - Enemy: 怪物音效（assets/audio/monsters/<category>/）
 // 三个通道彼此独立，可同时播放。
-
+// category 以 audioCategoryTable() 的句柄索引：bank 是按句柄下标的数组，播放时不哈希、不拷贝。
+// bank 由 AssetStore::audioBanks() 按 assets 目录在所有 AudioManager 之间共用，同一目录只扫描一次。
+// 播放优先走 SampleCache 里已解码的 PCM（QAudioSink），未命中才回退 QMediaPlayer 读盘，并触发整类预取。
+//
+// 设备操作都在专用的音频线程（AudioEngine）里：
+// - play/prefetch/stop/setVolume01 只把一条 AudioCommand 写进无锁 SPSC 队列就返回，不碰 QMediaPlayer
+// - 查 bank、随机选文件、SampleCache 查询、QAudioSink/QMediaPlayer 的 stop/setSource/play 都在音频线程
+// - 队列满（音频线程卡住）时新的 play/prefetch/stop 直接丢弃并计数，不阻塞调用方；
+//   音量和重建索引是原子状态，不会丢
+// 所有公开方法只在创建它的线程（GUI 线程，队列的唯一生产者）调用。
 class AudioManager : public QObject
 {
     Q_OBJECT
 public:
     explicit AudioManager(QObject *parent = nullptr);
+    ~AudioManager() override; // 等音频线程停下
 
     void setVolume01(double v); // 0.0-1.0
+
+    // 配置类调用（不频繁）：rebuildIndex 只置一个标记，音频线程在执行之后的命令前重建，扫描目录不占 GUI 线程；
+    // 别的 AudioManager 已经扫过同一目录时直接共用它的 bank
     void setAssetsRoot(const QString &assetsRoot);
     void rebuildIndex();
 
@@ -27,30 +89,85 @@ public:
 
     void stop();
 
-    // 三通道播放
+    // 三通道播放（句柄版本：热路径用）
+    void playVoice(int category);
+    void playSfx(int category);
+    void playEnemy(int category);
+
+    // 字符串版本：查一次句柄再转发
     void playVoice(const QString &category);
     void playSfx(const QString &category);
     void playEnemy(const QString &category);
 
+    // 预取：把该 category 的全部文件交给后台解码（已驻留的只刷新 LRU）
+    void prefetchVoice(int category);
+    void prefetchSfx(int category);
+    void prefetchEnemy(int category);
+
+    enum Channel : quint8
+    {
+        Voice,
+        Sfx,
+        Enemy,
+        ChannelCount
+    };
+
 private:
-    QString root;
-    double volume01 = 0.7;
+    QThread thread;
+    AudioEngine *engine = nullptr; // 住在 thread 里，线程结束时删除
+    AudioCommandQueue queue;
+    Metrics::Value *dropped = nullptr; // expldy_audio_commands_dropped_total
 
-    QMediaPlayer voicePlayer;
-    QAudioOutput voiceOut;
+    void push(const AudioCommand &cmd);
+    void wake(); // 投递一次 drain（已经投递过就不再投）
+};
 
-    QMediaPlayer sfxPlayer;
-    QAudioOutput sfxOut;
+// AudioEngine
+// 住在 AudioManager 的音频线程里：持有 bank、三个通道的播放器和输出设备，按顺序执行队列里的命令。
+class AudioEngine : public QObject
+{
+public:
+    AudioEngine(AudioCommandQueue &queue, SampleCache &cache);
+    ~AudioEngine() override;
 
-    QMediaPlayer enemyPlayer;
-    QAudioOutput enemyOut;
+    // 以下只在音频线程调用
+    void init(); // 创建播放器/输出（它们要属于音频线程）
+    void drain();
 
-    QHash<QString, QStringList> voiceBank;
-    QHash<QString, QStringList> sfxBank;
-    QHash<QString, QStringList> enemyBank;
+private:
+    AudioCommandQueue &queue;
+    SampleCache &cache; // AssetStore 里进程共享的一份
+
+    double volume01 = 0.7;
+    // 两条播放路径共用的增益：滑块 0.0-1.0 按对数刻度换成线性音量（QAudioOutput / QAudioSink 都只接受 0-1）
+    double gain() const;
+
+    QMediaDevices *devices = nullptr; // 默认输出设备变化时刷新 output
+    QAudioDevice output;              // PCM 路径用的设备：建 sink 前先确认它支持样本格式
 
-    QStringList scanAudioFiles(const QString &dirPath) const;
+    struct Channel
+    {
+        QMediaPlayer player; // 缓存未命中时的回退路径
+        QAudioOutput out;
+        QAudioSink *sink = nullptr; // PCM 路径，格式变化时重建
+        QBuffer buffer;
+        PcmSamplePtr playing; // 保活正在播放的样本，淘汰也不会影响
+        Metrics::Value *plays = nullptr; // expldy_audio_plays_total{channel=...}
+        Metrics::Value *failures = nullptr;
+    };
+    std::unique_ptr<Channel> channels[AudioManager::ChannelCount];
+
+    // AssetStore 里共用的一份；下标 = category 句柄
+    using Bank = QVector<QStringList>;
+    AudioBanksPtr banks;
+    const Bank &bankFor(int channel) const;
+
+    void applyConfig(); // 应用 queue 里待处理的音量/重建索引
+    void execute(const AudioCommand &cmd);
+    void rebuildIndex();
+    void applyVolume(double v01);
 
-    void rebuildBankFromDir(QHash<QString, QStringList> &outBank, const QString &baseDir);
-    void playFromBank(QMediaPlayer &p, const QHash<QString, QStringList> &bank, const QString &category);
+    void playFromBank(Channel &ch, const Bank &bank, int category);
+    void prefetchFromBank(const Bank &bank, int category);
+    void stopChannel(Channel &ch);
 };
@@ -0,0 +1,247 @@
+#include "controlserver.h"
+#include "wifelabel.h"
+#include "itemdb.h"
+#include "localserver.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+
+ControlServer::ControlServer(WifeLabel *target, QObject *parent)
+    : QObject(parent), target(target)
+{
+}
+
+QString ControlServer::defaultName()
+{
+    const QString env = qEnvironmentVariable("EXPLDY_CONTROL").trimmed();
+    return env.isEmpty() ? QStringLiteral("expldy-control") : env;
+}
+
+bool ControlServer::listen(const QString &name)
+{
+    if (name.isEmpty() || name.compare("off", Qt::CaseInsensitive) == 0)
+        return false;
+
+    if (!server)
+    {
+        server = new QLocalServer(this);
+        // 只允许当前用户连（Unix socket 权限 0700）
+        server->setSocketOptions(QLocalServer::UserAccessOption);
+        connect(server, &QLocalServer::newConnection, this, [this]()
+                { onNewConnection(); });
+    }
+
+    // 名字被另一个正在运行的实例占着时不接管；只清理崩溃留下的 socket
+    if (!listenLocalServer(*server, name))
+    {
+        qWarning() << "control server: cannot listen on" << name << server->errorString();
+        return false;
+    }
+    qDebug() << "control server listening on" << server->fullServerName();
+    return true;
+}
+
+QString ControlServer::serverName() const
+{
+    return server ? server->fullServerName() : QString();
+}
+
+void ControlServer::onNewConnection()
+{
+    while (QLocalSocket *sock = server->nextPendingConnection())
+    {
+        connect(sock, &QLocalSocket::readyRead, this, [this, sock]()
+                { onReadyRead(sock); });
+        connect(sock, &QLocalSocket::disconnected, this, [this, sock]()
+                {
+            pending.remove(sock);
+            sock->deleteLater(); });
+    }
+}
+
+void ControlServer::onReadyRead(QLocalSocket *sock)
+{
+    QByteArray &buf = pending[sock];
+    buf += sock->readAll();
+
+    int start = 0;
+    for (int nl = buf.indexOf('\n'); nl >= 0; nl = buf.indexOf('\n', start))
+    {
+        const QByteArray line = buf.mid(start, nl - start).trimmed();
+        start = nl + 1;
+        if (line.isEmpty())
+            continue;
+        sock->write(handleLine(line));
+        sock->write("\n");
+    }
+    buf.remove(0, start);
+
+    if (buf.size() > maxLineBytes)
+    {
+        qWarning() << "control server: line too long, dropping connection";
+        pending.remove(sock);
+        sock->abort();
+    }
+}
+
+QByteArray ControlServer::handleLine(const QByteArray &line)
+{
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &err);
+    if (err.error != QJsonParseError::NoError)
+    {
+        QJsonObject r;
+        r["ok"] = false;
+        r["error"] = QString("parse error: %1").arg(err.errorString());
+        return QJsonDocument(r).toJson(QJsonDocument::Compact);
+    }
+
+    QJsonArray cmds;
+    if (doc.isArray())
+        cmds = doc.array();
+    else if (doc.object().contains("cmds"))
+        cmds = doc.object().value("cmds").toArray();
+    else
+        cmds.append(doc.object());
+
+    return QJsonDocument(runBatch(cmds)).toJson(QJsonDocument::Compact);
+}
+
+QJsonObject ControlServer::runBatch(const QJsonArray &cmds)
+{
+    QElapsedTimer t;
+    t.start();
+
+    QJsonArray results;
+    bool allOk = true;
+    for (const QJsonValue &v : cmds)
+    {
+        QJsonObject r = runCommand(v.toObject());
+        allOk = allOk && r.value("ok").toBool();
+        results.append(r);
+    }
+
+    const qint64 us = t.nsecsElapsed() / 1000;
+    ++batches;
+    commands += cmds.size();
+    lastBatchUs = us;
+    maxBatchUs = std::max(maxBatchUs, us);
+    totalBatchUs += us;
+
+    QJsonObject out;
+    out["ok"] = allOk;
+    out["results"] = results;
+    out["elapsedUs"] = double(us);
+    return out;
+}
+
+int ControlServer::itemHandleFor(const QJsonObject &cmd) const
+{
+    const ItemCatalogPtr catalog = target->catalog();
+    const ItemDef *def = catalog->get(cmd.value("item").toString());
+    return def ? def->handle : -1;
+}
+
+QJsonObject ControlServer::runCommand(const QJsonObject &cmd)
+{
+    const QString op = cmd.value("op").toString();
+    QJsonObject r;
+    r["op"] = op;
+    r["ok"] = true;
+
+    auto fail = [&r](const QString &msg)
+    {
+        r["ok"] = false;
+        r["error"] = msg;
+        return r;
+    };
+
+    if (!target)
+        return fail("no target");
+
+    if (op == "spawn")
+    {
+        const int handle = itemHandleFor(cmd);
+        if (handle < 0)
+            return fail("unknown item");
+
+        const QJsonArray at = cmd.value("at").toArray();
+        const int count = std::clamp(cmd.value("count").toInt(std::max(1, int(at.size()))), 0, maxSpawnPerCommand);
+
+        QWidget *w = target->window();
+        const int maxX = std::max(1, w->width() - 64);
+        const int maxY = std::max(1, w->height() - 64);
+        auto *rng = QRandomGenerator::global();
+
+        int spawned = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            QPoint pos(rng->bounded(maxX), rng->bounded(maxY));
+            if (i < at.size())
+            {
+                const QJsonArray p = at.at(i).toArray();
+                pos = QPoint(p.at(0).toInt(), p.at(1).toInt());
+            }
+            if (target->spawnItemAt(handle, pos))
+                ++spawned;
+        }
+        r["spawned"] = spawned;
+        return r;
+    }
+
+    if (op == "equip")
+    {
+        const int handle = itemHandleFor(cmd);
+        if (handle < 0)
+            return fail("unknown item");
+        if (!target->equipItem(handle))
+            return fail("item is not a weapon or shield");
+        return r;
+    }
+
+    if (op == "play")
+    {
+        if (!target->playStateByName(cmd.value("state").toString()))
+            return fail("unknown state");
+        return r;
+    }
+
+    if (op == "volume")
+    {
+        target->setVolume(cmd.value("value").toInt());
+        return r;
+    }
+
+    if (op == "frequency")
+    {
+        target->setFrequency(cmd.value("value").toInt());
+        return r;
+    }
+
+    if (op == "clear")
+    {
+        r["cleared"] = target->clearItems();
+        return r;
+    }
+
+    if (op == "query")
+    {
+        QJsonObject timing;
+        timing["batches"] = double(batches);
+        timing["commands"] = double(commands);
+        timing["lastBatchUs"] = double(lastBatchUs);
+        timing["maxBatchUs"] = double(maxBatchUs);
+        timing["avgBatchUs"] = batches ? double(totalBatchUs) / double(batches) : 0.0;
+
+        r["stats"] = target->statsJson();
+        r["timing"] = timing;
+        return r;
+    }
+
+    return fail("unknown op");
+}
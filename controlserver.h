@@ -0,0 +1,65 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QByteArray>
+#include <QHash>
+#include <QElapsedTimer>
+
+class QLocalServer;
+class QLocalSocket;
+class WifeLabel;
+
+// ControlServer
+// 本地 IPC 控制口（QLocalServer，Unix socket / Windows named pipe），给脚本驱动：
+// 刷怪潮、演示、长时间 soak 测试，不用再模拟鼠标事件。
+//
+// 协议：按行分隔的 JSON。每行是一批命令（数组，或 {"cmds":[...]}，或单个命令对象），
+// 整批在同一次 readyRead 里同步执行完（同一个事件循环回合），然后回一行：
+//   {"ok":true,"results":[...],"elapsedUs":123}
+//
+// 命令（op）：
+//   spawn     {"op":"spawn","item":"apple","count":10,"at":[[x,y],...]}  at 不够时在窗口内随机
+//   equip     {"op":"equip","item":"sword"}
+//   play      {"op":"play","state":"happy"}        idle/happy/angry/eat/attack/defend/hit
+//   volume    {"op":"volume","value":50}
+//   frequency {"op":"frequency","value":50}
+//   clear     {"op":"clear"}                        回收所有未装备物品
+//   query     {"op":"query"}                        实体数量、对象池、控制口计时
+//
+// 服务名默认 "expldy-control"，可用环境变量 EXPLDY_CONTROL 改名；设成 "off" 则不监听。
+class ControlServer : public QObject
+{
+public:
+    explicit ControlServer(WifeLabel *target, QObject *parent = nullptr);
+
+    bool listen(const QString &name);
+    QString serverName() const;
+
+    static QString defaultName();
+
+    // 执行一批命令（也方便不经 socket 直接调用）
+    QJsonObject runBatch(const QJsonArray &cmds);
+
+private:
+    WifeLabel *target = nullptr;
+    QLocalServer *server = nullptr;
+    QHash<QLocalSocket *, QByteArray> pending; // 每个连接未凑满一行的数据
+
+    // 计时：query 里一起返回
+    qint64 batches = 0;
+    qint64 commands = 0;
+    qint64 lastBatchUs = 0;
+    qint64 maxBatchUs = 0;
+    qint64 totalBatchUs = 0;
+
+    static constexpr int maxSpawnPerCommand = 2000;
+    static constexpr int maxLineBytes = 1 << 20;
+
+    void onNewConnection();
+    void onReadyRead(QLocalSocket *sock);
+    QByteArray handleLine(const QByteArray &line);
+    QJsonObject runCommand(const QJsonObject &cmd);
+    int itemHandleFor(const QJsonObject &cmd) const;
+};
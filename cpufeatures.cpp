@@ -0,0 +1,79 @@
+#include "cpufeatures.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+namespace
+{
+    bool hasAvx2()
+    {
+#if defined(EXPLDY_SIMD_AVX2)
+        static const bool avx2 = []()
+        {
+            __builtin_cpu_init();
+            return bool(__builtin_cpu_supports("avx2"));
+        }();
+        return avx2;
+#else
+        return false;
+#endif
+    }
+}
+
+bool simdSupported(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return true;
+    case SimdLevel::Sse2:
+#if defined(EXPLDY_SIMD_X86)
+        return true;
+#else
+        return false;
+#endif
+    case SimdLevel::Avx2:
+        return hasAvx2();
+    case SimdLevel::Neon:
+#if defined(EXPLDY_SIMD_NEON)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+SimdLevel simdLevel()
+{
+    static const SimdLevel level = []()
+    {
+        const char *force = std::getenv("EXPLDY_SCALER");
+        if (force && std::strcmp(force, "scalar") == 0)
+            return SimdLevel::Scalar;
+        for (SimdLevel l : {SimdLevel::Avx2, SimdLevel::Sse2, SimdLevel::Neon})
+        {
+            if (simdSupported(l))
+                return l;
+        }
+        return SimdLevel::Scalar;
+    }();
+    return level;
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        break;
+    case SimdLevel::Sse2:
+        return "sse2";
+    case SimdLevel::Avx2:
+        return "avx2";
+    case SimdLevel::Neon:
+        return "neon";
+    }
+    return "scalar";
+}
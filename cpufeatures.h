@@ -0,0 +1,31 @@
+#pragma once
+
+// 运行时 CPU 特性：framescaler / frameblend 的 SIMD 内核都按这里选路径，只检测一次。
+// - x86：SSE2 是基线，AVX2 运行时检测（内核用 __attribute__((target))，只在 GCC/Clang 下编译）
+// - ARM：NEON 是基线；其他平台只有标量
+// - EXPLDY_SCALER=scalar 强制标量（对比/排查用）
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define EXPLDY_SIMD_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#define EXPLDY_SIMD_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define EXPLDY_SIMD_NEON 1
+#endif
+
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Neon
+};
+
+// 本机可用、且没被 EXPLDY_SCALER 关掉的最高一级
+SimdLevel simdLevel();
+
+// 本机能不能跑这一级的内核（不看环境变量；Scalar 总是可以）
+bool simdSupported(SimdLevel level);
+
+// "scalar" / "sse2" / "avx2" / "neon"
+const char *simdLevelName(SimdLevel level);
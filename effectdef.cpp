@@ -0,0 +1,40 @@
+#include "effectdef.h"
+
+EffectDef EffectDef::preset(const QString &name)
+{
+    EffectDef d;
+    const QString n = name.trimmed().toLower();
+    if (n == "crumbs")
+    {
+        d.shape = Shape::Square;
+        d.count = 14;
+        d.color = qRgba(196, 140, 80, 255);
+        d.speed = 140.f;
+        d.spread = 160.f;
+        d.lifeMs = 600.f;
+        d.size = 3.f;
+        d.gravity = 700.f;
+    }
+    else if (n == "sparks")
+    {
+        d.shape = Shape::Spark;
+        d.count = 18;
+        d.color = qRgba(255, 220, 120, 255);
+        d.speed = 320.f;
+        d.spread = 360.f;
+        d.lifeMs = 280.f;
+        d.size = 2.f;
+        d.gravity = 200.f;
+    }
+    else if (n == "flash")
+    {
+        d.shape = Shape::Flash;
+        d.count = 1;
+        d.color = qRgba(255, 255, 255, 200);
+        d.speed = 0.f;
+        d.lifeMs = 160.f;
+        d.size = 28.f;
+        d.gravity = 0.f;
+    }
+    return d;
+}
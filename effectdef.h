@@ -0,0 +1,28 @@
+#pragma once
+#include <QRgb>
+#include <QString>
+
+// 一次发射的配置：manifest.effects 里每个事件一项，也用作内置预设
+struct EffectDef
+{
+    enum class Shape : quint8
+    {
+        Square, // 碎屑：小方块
+        Spark,  // 火花：沿速度方向的短线
+        Flash   // 闪光：扩散并淡出的圆
+    };
+
+    Shape shape = Shape::Square;
+    int count = 0;           // 0 表示不发射
+    QRgb color = 0xffffffff; // 非 premultiplied ARGB
+    float speed = 120.f;     // 初速度上限，像素/秒
+    float spread = 360.f;    // 发射扇形角（度），中心朝上
+    float lifeMs = 500.f;
+    float size = 3.f;        // 边长/线宽/闪光最终半径
+    float gravity = 600.f;   // 像素/秒²，向下为正
+
+    bool isNull() const { return count <= 0; }
+
+    // "crumbs" / "sparks" / "flash"；不认识返回空配置
+    static EffectDef preset(const QString &name);
+};
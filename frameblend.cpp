@@ -0,0 +1,232 @@
+#include "frameblend.h"
+
+#include <QImage>
+#include <QVector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(EXPLDY_SIMD_X86)
+#include <immintrin.h>
+#elif defined(EXPLDY_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    using LerpFn = void (*)(const uint8_t *a, const uint8_t *b, uint8_t *dst, qsizetype n, int t);
+
+    // (a * (256 - t) + b * t + 128) >> 8：两端精确（t=0 得 a，t=256 得 b），
+    // 并且保持 premultiplied 的 c <= alpha 不变
+    void lerpScalar(const uint8_t *a, const uint8_t *b, uint8_t *dst, qsizetype n, int t)
+    {
+        const int s = 256 - t;
+        for (qsizetype i = 0; i < n; ++i)
+            dst[i] = uint8_t((a[i] * s + b[i] * t + 128) >> 8);
+    }
+
+#if defined(EXPLDY_SIMD_X86)
+    void lerpSse2(const uint8_t *a, const uint8_t *b, uint8_t *dst, qsizetype n, int t)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wa = _mm_set1_epi16(short(256 - t));
+        const __m128i wb = _mm_set1_epi16(short(t));
+        const __m128i round = _mm_set1_epi16(128);
+        qsizetype i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            // 16 位里最大 255*256 = 65280，加 128 也不溢出（按无符号理解）
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                       _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                       _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        if (i < n)
+            lerpScalar(a + i, b + i, dst + i, n - i, t);
+    }
+
+#if defined(EXPLDY_SIMD_AVX2)
+    __attribute__((target("avx2"))) void lerpAvx2(const uint8_t *a, const uint8_t *b, uint8_t *dst, qsizetype n, int t)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i wa = _mm256_set1_epi16(short(256 - t));
+        const __m256i wb = _mm256_set1_epi16(short(t));
+        const __m256i round = _mm256_set1_epi16(128);
+        qsizetype i = 0;
+        for (; i + 32 <= n; i += 32)
+        {
+            const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            // unpack/pack 都在 128 位 lane 内进行，两次互逆，顺序不变
+            __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), wa),
+                                          _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), wb));
+            __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), wa),
+                                          _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), wb));
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_packus_epi16(lo, hi));
+        }
+        if (i < n)
+            lerpSse2(a + i, b + i, dst + i, n - i, t);
+    }
+#endif
+#endif // EXPLDY_SIMD_X86
+
+#if defined(EXPLDY_SIMD_NEON)
+    void lerpNeon(const uint8_t *a, const uint8_t *b, uint8_t *dst, qsizetype n, int t)
+    {
+        const uint16_t wa = uint16_t(256 - t);
+        const uint16_t wb = uint16_t(t);
+        const uint16x8_t round = vdupq_n_u16(128);
+        qsizetype i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            const uint8x16_t va = vld1q_u8(a + i);
+            const uint8x16_t vb = vld1q_u8(b + i);
+            uint16x8_t lo = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_low_u8(va)), wa), vmovl_u8(vget_low_u8(vb)), wb);
+            uint16x8_t hi = vmlaq_n_u16(vmulq_n_u16(vmovl_u8(vget_high_u8(va)), wa), vmovl_u8(vget_high_u8(vb)), wb);
+            lo = vaddq_u16(lo, round);
+            hi = vaddq_u16(hi, round);
+            vst1q_u8(dst + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        }
+        if (i < n)
+            lerpScalar(a + i, b + i, dst + i, n - i, t);
+    }
+#endif // EXPLDY_SIMD_NEON
+
+    struct BlendKernel
+    {
+        LerpFn lerp;
+        const char *name;
+    };
+
+    // 本机不支持的 level 退回标量
+    BlendKernel pickKernel(SimdLevel level)
+    {
+        if (!simdSupported(level))
+            level = SimdLevel::Scalar;
+        switch (level)
+        {
+#if defined(EXPLDY_SIMD_AVX2)
+        case SimdLevel::Avx2:
+            return {lerpAvx2, "avx2"};
+#endif
+#if defined(EXPLDY_SIMD_X86)
+        case SimdLevel::Sse2:
+            return {lerpSse2, "sse2"};
+#endif
+#if defined(EXPLDY_SIMD_NEON)
+        case SimdLevel::Neon:
+            return {lerpNeon, "neon"};
+#endif
+        default:
+            break;
+        }
+        return {lerpScalar, "scalar"};
+    }
+
+    const BlendKernel &kernel()
+    {
+        static const BlendKernel k = pickKernel(simdLevel());
+        return k;
+    }
+
+    // 工作缓冲区池：切换时借出，用完归还，尺寸够就复用（只在 GUI 线程用）
+    QVector<QImage> &freeBuffers()
+    {
+        static QVector<QImage> buffers;
+        return buffers;
+    }
+
+    QImage takeBuffer(const QSize &size)
+    {
+        auto &pool = freeBuffers();
+        for (int i = 0; i < pool.size(); ++i)
+        {
+            if (pool[i].size() == size)
+                return pool.takeAt(i);
+        }
+        return QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+
+    void giveBuffer(QImage img)
+    {
+        auto &pool = freeBuffers();
+        constexpr int kMaxPooled = 6;
+        if (pool.size() >= kMaxPooled)
+            pool.removeFirst();
+        pool.push_back(std::move(img));
+    }
+
+    // 把一帧放进 union 大小的透明缓冲：帧外全 0（premultiplied 透明）
+    void placeFrame(QImage &buf, const SpriteFrame &f, const QPoint &origin)
+    {
+        buf.fill(Qt::transparent);
+        const QImage src = f.pixmap.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        const QPoint at = f.offset - origin;
+        const qsizetype rowBytes = qsizetype(src.width()) * 4;
+        for (int y = 0; y < src.height(); ++y)
+            std::memcpy(buf.scanLine(at.y() + y) + qsizetype(at.x()) * 4, src.constScanLine(y), size_t(rowBytes));
+    }
+}
+
+void lerpPremultiplied(const uchar *a, const uchar *b, uchar *dst, qsizetype bytes, int t256)
+{
+    kernel().lerp(a, b, dst, bytes, std::clamp(t256, 0, 256));
+}
+
+void lerpPremultiplied(const uchar *a, const uchar *b, uchar *dst, qsizetype bytes, int t256, SimdLevel level)
+{
+    pickKernel(level).lerp(a, b, dst, bytes, std::clamp(t256, 0, 256));
+}
+
+const char *frameBlendBackend()
+{
+    return kernel().name;
+}
+
+SpriteFrames renderCrossfade(const SpriteFrame &from, const SpriteFrame &to, int steps)
+{
+    SpriteFrames out;
+    if (steps <= 0 || from.pixmap.isNull() || to.pixmap.isNull())
+        return out;
+
+    const QRect u = from.rect().united(to.rect());
+    QImage a = takeBuffer(u.size());
+    QImage b = takeBuffer(u.size());
+    QImage mix = takeBuffer(u.size());
+    placeFrame(a, from, u.topLeft());
+    placeFrame(b, to, u.topLeft());
+
+    // 三块缓冲尺寸相同、每行无填充时可以整块插值
+    const bool packed = a.bytesPerLine() == qsizetype(u.width()) * 4;
+    out.reserve(steps);
+    for (int k = 1; k <= steps; ++k)
+    {
+        const int t = (256 * k) / (steps + 1);
+        if (packed)
+        {
+            lerpPremultiplied(a.constBits(), b.constBits(), mix.bits(), a.sizeInBytes(), t);
+        }
+        else
+        {
+            for (int y = 0; y < u.height(); ++y)
+                lerpPremultiplied(a.constScanLine(y), b.constScanLine(y), mix.scanLine(y), qsizetype(u.width()) * 4, t);
+        }
+
+        SpriteFrame f;
+        f.pixmap = QPixmap::fromImage(mix); // 拷一份：mix 留着给下一步复用
+        f.offset = u.topLeft();
+        out.push_back(f);
+    }
+
+    giveBuffer(std::move(a));
+    giveBuffer(std::move(b));
+    giveBuffer(std::move(mix));
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <QtGlobal>
+
+#include "assetstore.h"
+#include "cpufeatures.h"
+
+// 状态切换的交叉淡化帧：在 premultiplied ARGB32 上逐字节线性插值（premultiplied 下 lerp 本身就是正确的混合，
+// 不需要 QPainter 合成），结果一次性转成 QPixmap，播放时和普通帧一样只是 blit。
+// - 内核按 CPU 运行时选择（cpufeatures.h）：AVX2 / SSE2 / NEON，标量兜底（EXPLDY_SCALER=scalar 同样强制标量）；
+//   各内核的结果逐字节相同（tests/simd_parity.cpp）
+// - 工作缓冲区复用，不随每次切换分配
+
+// dst = a + (b - a) * t / 256，逐字节；t 取 0..256
+void lerpPremultiplied(const uchar *a, const uchar *b, uchar *dst, qsizetype bytes, int t256);
+
+// 指定内核（对拍测试用）；本机不支持的 level 退回标量
+void lerpPremultiplied(const uchar *a, const uchar *b, uchar *dst, qsizetype bytes, int t256, SimdLevel level);
+
+// 当前选中的内核名（"avx2" / "sse2" / "neon" / "scalar"），用于日志
+const char *frameBlendBackend();
+
+// from 渐变到 to 的 steps 张中间帧（不含两端）。每张覆盖两帧包围盒的并集，offset 是并集在画布里的位置。
+// 中间帧不进帧池（id = -1）；缓存见 AssetStore::crossfade()
+SpriteFrames renderCrossfade(const SpriteFrame &from, const SpriteFrame &to, int steps);
@@ -0,0 +1,296 @@
+#include "framescaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(EXPLDY_SIMD_X86)
+#include <immintrin.h>
+#elif defined(EXPLDY_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    // 一个轴上的面积平均系数：目标像素 i 覆盖源区间 [i*scale, (i+1)*scale)，
+    // 每个被覆盖的源像素按覆盖长度加权，权重和为 1。
+    struct AxisTaps
+    {
+        std::vector<int> first;  // 第一个源像素
+        std::vector<int> count;  // 覆盖的源像素个数
+        std::vector<int> offset; // 在 weights 里的起点
+        std::vector<float> weights;
+    };
+
+    AxisTaps buildTaps(int srcLen, int dstLen)
+    {
+        AxisTaps t;
+        t.first.resize(dstLen);
+        t.count.resize(dstLen);
+        t.offset.resize(dstLen);
+
+        const double scale = double(srcLen) / dstLen;
+        for (int i = 0; i < dstLen; ++i)
+        {
+            const double a = i * scale;
+            const double b = std::min<double>((i + 1) * scale, srcLen);
+            const int s0 = int(a);
+            const int s1 = std::min(srcLen, int(std::ceil(b)));
+
+            t.first[i] = s0;
+            t.count[i] = s1 - s0;
+            t.offset[i] = int(t.weights.size());
+            for (int s = s0; s < s1; ++s)
+            {
+                const double w = (std::min<double>(b, s + 1) - std::max<double>(a, s)) / scale;
+                t.weights.push_back(float(w));
+            }
+        }
+        return t;
+    }
+
+    // 竖直方向：acc[0..width*4) += w * row（4 通道各自独立，字节序无关）
+    using AccumulateFn = void (*)(float *acc, const uint8_t *row, int width, float w);
+    // 水平方向：按 tx 把 acc 收成一行目标像素
+    using ResolveFn = void (*)(uint8_t *dst, const float *acc, const AxisTaps &tx, int dstW);
+
+    void accumulateRowScalar(float *acc, const uint8_t *row, int width, float w)
+    {
+        const int n = width * 4;
+        for (int i = 0; i < n; ++i)
+            acc[i] += w * row[i];
+    }
+
+    void resolveRowScalar(uint8_t *dst, const float *acc, const AxisTaps &tx, int dstW)
+    {
+        for (int x = 0; x < dstW; ++x)
+        {
+            float c[4] = {0.f, 0.f, 0.f, 0.f};
+            const float *w = tx.weights.data() + tx.offset[x];
+            const float *p = acc + size_t(tx.first[x]) * 4;
+            for (int k = 0; k < tx.count[x]; ++k, p += 4)
+                for (int j = 0; j < 4; ++j)
+                    c[j] += w[k] * p[j];
+            for (int j = 0; j < 4; ++j)
+                dst[x * 4 + j] = uint8_t(std::min(255.f, c[j] + 0.5f));
+        }
+    }
+
+#if defined(EXPLDY_SIMD_X86)
+    void accumulateRowSse2(float *acc, const uint8_t *row, int width, float w)
+    {
+        const __m128 wv = _mm_set1_ps(w);
+        const __m128i zero = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= width; i += 4)
+        {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i * 4));
+            const __m128i lo = _mm_unpacklo_epi8(px, zero);
+            const __m128i hi = _mm_unpackhi_epi8(px, zero);
+            const __m128 p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+            const __m128 p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+            const __m128 p2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+            const __m128 p3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+
+            float *a = acc + i * 4;
+            _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), _mm_mul_ps(p0, wv)));
+            _mm_storeu_ps(a + 4, _mm_add_ps(_mm_loadu_ps(a + 4), _mm_mul_ps(p1, wv)));
+            _mm_storeu_ps(a + 8, _mm_add_ps(_mm_loadu_ps(a + 8), _mm_mul_ps(p2, wv)));
+            _mm_storeu_ps(a + 12, _mm_add_ps(_mm_loadu_ps(a + 12), _mm_mul_ps(p3, wv)));
+        }
+        if (i < width)
+            accumulateRowScalar(acc + i * 4, row + i * 4, width - i, w);
+    }
+
+    void resolveRowSse2(uint8_t *dst, const float *acc, const AxisTaps &tx, int dstW)
+    {
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (int x = 0; x < dstW; ++x)
+        {
+            __m128 c = _mm_setzero_ps();
+            const float *w = tx.weights.data() + tx.offset[x];
+            const float *p = acc + size_t(tx.first[x]) * 4;
+            for (int k = 0; k < tx.count[x]; ++k, p += 4)
+                c = _mm_add_ps(c, _mm_mul_ps(_mm_loadu_ps(p), _mm_set1_ps(w[k])));
+
+            __m128i v = _mm_cvttps_epi32(_mm_add_ps(c, half));
+            v = _mm_packs_epi32(v, v);
+            v = _mm_packus_epi16(v, v);
+            const int px = _mm_cvtsi128_si32(v);
+            std::memcpy(dst + x * 4, &px, 4);
+        }
+    }
+
+#if defined(EXPLDY_SIMD_AVX2)
+    // 乘和加分开做（不用 FMA）：每一步的舍入和标量、SSE2 完全一样，结果逐字节相同
+    __attribute__((target("avx2"))) void accumulateRowAvx2(float *acc, const uint8_t *row, int width, float w)
+    {
+        const __m256 wv = _mm256_set1_ps(w);
+        int i = 0;
+        for (; i + 4 <= width; i += 4)
+        {
+            // 每次 2 像素（8 字节）扩成 8 个 float，一次循环 4 像素
+            const __m128i px01 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i * 4));
+            const __m128i px23 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i * 4 + 8));
+            const __m256 p01 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(px01));
+            const __m256 p23 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(px23));
+
+            float *a = acc + i * 4;
+            _mm256_storeu_ps(a, _mm256_add_ps(_mm256_loadu_ps(a), _mm256_mul_ps(p01, wv)));
+            _mm256_storeu_ps(a + 8, _mm256_add_ps(_mm256_loadu_ps(a + 8), _mm256_mul_ps(p23, wv)));
+        }
+        if (i < width)
+            accumulateRowScalar(acc + i * 4, row + i * 4, width - i, w);
+    }
+#endif
+#endif // EXPLDY_SIMD_X86
+
+#if defined(EXPLDY_SIMD_NEON)
+    void accumulateRowNeon(float *acc, const uint8_t *row, int width, float w)
+    {
+        const float32x4_t wv = vdupq_n_f32(w);
+        int i = 0;
+        for (; i + 4 <= width; i += 4)
+        {
+            const uint8x16_t px = vld1q_u8(row + i * 4);
+            const uint16x8_t lo = vmovl_u8(vget_low_u8(px));
+            const uint16x8_t hi = vmovl_u8(vget_high_u8(px));
+            const float32x4_t p0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo)));
+            const float32x4_t p1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo)));
+            const float32x4_t p2 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi)));
+            const float32x4_t p3 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)));
+
+            float *a = acc + i * 4;
+            vst1q_f32(a, vmlaq_f32(vld1q_f32(a), p0, wv));
+            vst1q_f32(a + 4, vmlaq_f32(vld1q_f32(a + 4), p1, wv));
+            vst1q_f32(a + 8, vmlaq_f32(vld1q_f32(a + 8), p2, wv));
+            vst1q_f32(a + 12, vmlaq_f32(vld1q_f32(a + 12), p3, wv));
+        }
+        if (i < width)
+            accumulateRowScalar(acc + i * 4, row + i * 4, width - i, w);
+    }
+
+    void resolveRowNeon(uint8_t *dst, const float *acc, const AxisTaps &tx, int dstW)
+    {
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        for (int x = 0; x < dstW; ++x)
+        {
+            float32x4_t c = vdupq_n_f32(0.f);
+            const float *w = tx.weights.data() + tx.offset[x];
+            const float *p = acc + size_t(tx.first[x]) * 4;
+            for (int k = 0; k < tx.count[x]; ++k, p += 4)
+                c = vmlaq_n_f32(c, vld1q_f32(p), w[k]);
+
+            const uint16x4_t v16 = vqmovn_u32(vcvtq_u32_f32(vaddq_f32(c, half)));
+            const uint8x8_t v8 = vqmovn_u16(vcombine_u16(v16, v16));
+            vst1_lane_u32(reinterpret_cast<uint32_t *>(dst + x * 4), vreinterpret_u32_u8(v8), 0);
+        }
+    }
+#endif // EXPLDY_SIMD_NEON
+
+    struct ScalerKernels
+    {
+        AccumulateFn accumulate;
+        ResolveFn resolve;
+        const char *name;
+    };
+
+    // 本机不支持的 level 退回标量
+    ScalerKernels pickKernels(SimdLevel level)
+    {
+        if (!simdSupported(level))
+            level = SimdLevel::Scalar;
+        switch (level)
+        {
+#if defined(EXPLDY_SIMD_AVX2)
+        case SimdLevel::Avx2:
+            return {accumulateRowAvx2, resolveRowSse2, "avx2"};
+#endif
+#if defined(EXPLDY_SIMD_X86)
+        case SimdLevel::Sse2:
+            return {accumulateRowSse2, resolveRowSse2, "sse2"};
+#endif
+#if defined(EXPLDY_SIMD_NEON)
+        case SimdLevel::Neon:
+            return {accumulateRowNeon, resolveRowNeon, "neon"};
+#endif
+        default:
+            break;
+        }
+        return {accumulateRowScalar, resolveRowScalar, "scalar"};
+    }
+
+    const ScalerKernels &kernels()
+    {
+        static const ScalerKernels k = pickKernels(simdLevel());
+        return k;
+    }
+
+    // 面积平均缩小：先竖直把覆盖到的源行加权累加到一行 float，再水平收成目标行，
+    // 结果直接写进 dst（调用方传入的是画布里居中区域的左上角）。
+    void scaleArea(const ScalerKernels &k, const uint8_t *src, qsizetype srcStride, int srcW, int srcH,
+                   uint8_t *dst, qsizetype dstStride, int dstW, int dstH)
+    {
+        const AxisTaps tx = buildTaps(srcW, dstW);
+        const AxisTaps ty = buildTaps(srcH, dstH);
+
+        std::vector<float> acc(size_t(srcW) * 4);
+        for (int y = 0; y < dstH; ++y)
+        {
+            std::fill(acc.begin(), acc.end(), 0.f);
+            const float *wy = ty.weights.data() + ty.offset[y];
+            for (int j = 0; j < ty.count[y]; ++j)
+                k.accumulate(acc.data(), src + (ty.first[y] + j) * srcStride, srcW, wy[j]);
+            k.resolve(dst + y * dstStride, acc.data(), tx, dstW);
+        }
+    }
+
+    QImage scaleWith(const ScalerKernels &k, const QImage &srcIn, const QSize &targetSize)
+    {
+        if (srcIn.isNull() || targetSize.isEmpty())
+            return QImage();
+
+        QImage canvas(targetSize, QImage::Format_ARGB32_Premultiplied);
+        canvas.fill(Qt::transparent);
+
+        // 与原来 QPixmap::scaled(KeepAspectRatio) + 居中绘制完全相同的落点
+        const QSize fit = srcIn.size().scaled(targetSize, Qt::KeepAspectRatio);
+        if (fit.isEmpty())
+            return canvas;
+        const int ox = (targetSize.width() - fit.width()) / 2;
+        const int oy = (targetSize.height() - fit.height()) / 2;
+
+        if (fit.width() > srcIn.width() || fit.height() > srcIn.height())
+        {
+            // 放大不是热路径：交给 Qt，但同样直接拷进画布，不经过 QPainter
+            const QImage up = srcIn.scaled(fit, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                                  .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            for (int y = 0; y < fit.height(); ++y)
+                std::memcpy(canvas.scanLine(oy + y) + ox * 4, up.constScanLine(y), size_t(fit.width()) * 4);
+            return canvas;
+        }
+
+        const QImage src = srcIn.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        scaleArea(k, src.constBits(), src.bytesPerLine(), src.width(), src.height(),
+                  canvas.bits() + oy * canvas.bytesPerLine() + ox * 4, canvas.bytesPerLine(),
+                  fit.width(), fit.height());
+        return canvas;
+    }
+}
+
+const char *frameScalerBackend()
+{
+    return kernels().name;
+}
+
+QImage scaleIntoCanvas(const QImage &src, const QSize &targetSize)
+{
+    return scaleWith(kernels(), src, targetSize);
+}
+
+QImage scaleIntoCanvas(const QImage &src, const QSize &targetSize, SimdLevel level)
+{
+    return scaleWith(pickKernels(level), src, targetSize);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <QImage>
+#include <QSize>
+
+#include "cpufeatures.h"
+
+// 帧归一化的快速路径：把 src 按 KeepAspectRatio 缩到 targetSize 内，居中写进透明画布。
+// - 统一在 premultiplied ARGB32 上做，缩小用面积平均核（大比例缩小不失真）
+// - 一遍写入最终画布，不经过中间 QPixmap / QPainter
+// - 内核按 CPU 运行时选择（cpufeatures.h）：AVX2 / SSE2 / NEON，标量兜底（EXPLDY_SCALER=scalar 可强制）；
+//   各内核的结果逐字节相同（tests/simd_parity.cpp）
+QImage scaleIntoCanvas(const QImage &src, const QSize &targetSize);
+
+// 指定内核（对拍测试用）；本机不支持的 level 退回标量
+QImage scaleIntoCanvas(const QImage &src, const QSize &targetSize, SimdLevel level);
+
+// 当前选中的内核名（"avx2" / "sse2" / "neon" / "scalar"），用于日志
+const char *frameScalerBackend();
@@ -0,0 +1,52 @@
+#include "interaction.h"
+#include "audiomanager.h"
+
+DropAction decideDrop(const ItemDef &def, bool onCharacter, bool equipped)
+{
+    switch (def.type)
+    {
+    case ItemType::Food:
+        return onCharacter ? DropAction::Eat : DropAction::None;
+    case ItemType::Weapon:
+        if (onCharacter)
+            return DropAction::EquipWeapon;
+        // 只有“曾经装备过”的武器，拖离角色才销毁
+        return equipped ? DropAction::DiscardEquipped : DropAction::None;
+    case ItemType::Shield:
+        if (onCharacter)
+            return DropAction::EquipShield;
+        return equipped ? DropAction::DiscardEquipped : DropAction::None;
+    case ItemType::Monster:
+        return onCharacter ? DropAction::AnchorMonster : DropAction::None;
+    case ItemType::Misc:
+        break;
+    }
+    return DropAction::None;
+}
+
+void playDropAudio(AudioManager &audio, const ItemDef &def, DropAction action, bool spawned, int eatVoice)
+{
+    switch (action)
+    {
+    case DropAction::Eat:
+    {
+        // 角色+物品双音效（如果 manifest 配了）
+        const int actorUse = def.audioFor(ItemEvent::ActorUse);
+        audio.playVoice(actorUse >= 0 ? actorUse : eatVoice); // 没配就默认
+        audio.playSfx(def.audioFor(ItemEvent::ItemUse));
+        break;
+    }
+    case DropAction::EquipWeapon:
+    case DropAction::EquipShield:
+        audio.playVoice(def.audioFor(ItemEvent::ActorUse));
+        audio.playSfx(def.audioFor(ItemEvent::ItemUse));
+        break;
+    case DropAction::AnchorMonster:
+        if (!spawned)
+            audio.playEnemy(def.audioFor(ItemEvent::EnemySpawn));
+        break;
+    case DropAction::DiscardEquipped:
+    case DropAction::None:
+        break;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "itemdb.h"
+
+class AudioManager;
+
+// 物品松手后的规则：widget 版（WifeLabel）和 Qt Quick 版（PetStage）共用，
+// 两个前端只负责执行结果（回池/挂到角色身上/吸附位置/播动画），判定和音效在这里。
+enum class DropAction
+{
+    None,            // 留在原地（或交给物理下落）
+    Eat,             // 食物放到角色身上：吃掉
+    EquipWeapon,     // 武器放到角色身上：装备
+    EquipShield,     // 盾放到角色身上：装备
+    DiscardEquipped, // 装备过的武器/盾被拖离角色：销毁
+    AnchorMonster    // 怪物放到角色身上：生成为场景实体，吸附到角色旁边
+};
+
+DropAction decideDrop(const ItemDef &def, bool onCharacter, bool equipped);
+
+// 这次松手对应的音效。spawned：怪物之前是否已经生成过（只在第一次叫）；
+// eatVoice：食物没配 actor_use 时的默认 voice category
+void playDropAudio(AudioManager &audio, const ItemDef &def, DropAction action, bool spawned, int eatVoice);
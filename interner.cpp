@@ -0,0 +1,33 @@
+#include "interner.h"
+
+int Interner::intern(const QString &s)
+{
+    {
+        QReadLocker lock(&mutex);
+        auto it = ids.constFind(s);
+        if (it != ids.constEnd())
+            return it.value();
+    }
+
+    QWriteLocker lock(&mutex);
+    auto it = ids.constFind(s); // 两次加锁之间可能已被别的线程插入
+    if (it != ids.constEnd())
+        return it.value();
+
+    const int id = names.size();
+    names.push_back(s);
+    ids.insert(s, id);
+    return id;
+}
+
+Interner &itemIdTable()
+{
+    static Interner t;
+    return t;
+}
+
+Interner &audioCategoryTable()
+{
+    static Interner t;
+    return t;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QReadWriteLock>
+
+// Interner
+// 加载时把字符串（item id / 音频 category）转换成稠密整数句柄。
+// 句柄从 0 开始连续分配，可直接当数组下标；运行时的分发只做数组访问，不再哈希字符串。
+// 线程安全：物品库在工作线程加载时也会 intern（读锁查、未命中再写锁插入）。
+class Interner
+{
+public:
+    // 已存在则返回原句柄，否则分配新句柄
+    int intern(const QString &s);
+
+    // 只查不加：找不到返回 -1
+    int find(const QString &s) const
+    {
+        QReadLocker lock(&mutex);
+        return ids.value(s, -1);
+    }
+
+    QString name(int id) const
+    {
+        QReadLocker lock(&mutex);
+        return names.value(id);
+    }
+    int size() const
+    {
+        QReadLocker lock(&mutex);
+        return names.size();
+    }
+
+private:
+    mutable QReadWriteLock mutex;
+    QHash<QString, int> ids;
+    QStringList names;
+};
+
+// 进程级的两张表：ItemDB / AudioManager / WifeLabel 共用同一套句柄
+Interner &itemIdTable();
+Interner &audioCategoryTable();
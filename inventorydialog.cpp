@@ -1,11 +1,14 @@
 #include "inventorydialog.h"
+#include "inventorymodel.h"
 #include "itemdb.h"
-#include "animateditembutton.h"
+#include "powerpolicy.h"
 
 #include <QVBoxLayout>
-#include <QGridLayout>
-#include <QScrollArea>
+#include <QListView>
 #include <QLabel>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QHBoxLayout>
 
 InventoryDialog::InventoryDialog(QWidget *parent)
     : QDialog(parent)
@@ -21,74 +24,136 @@ InventoryDialog::InventoryDialog(QWidget *parent)
     auto *tip = new QLabel("Click an item to spawn it.", this);
     root->addWidget(tip);
 
-    auto *scroll = new QScrollArea(this);
-    scroll->setWidgetResizable(true);
-    root->addWidget(scroll, 1);
-
-    auto *container = new QWidget(scroll);
-    scroll->setWidget(container);
-
-    auto *grid = new QGridLayout(container);
-    grid->setContentsMargins(0, 0, 0, 0);
-    grid->setHorizontalSpacing(8);
-    grid->setVerticalSpacing(8);
-    container->setLayout(grid);
+    auto *filterRow = new QHBoxLayout();
+    filterRow->setSpacing(6);
+
+    searchEdit = new QLineEdit(this);
+    searchEdit->setPlaceholderText("Search name / id");
+    searchEdit->setClearButtonEnabled(true);
+    filterRow->addWidget(searchEdit, 1);
+
+    typeCombo = new QComboBox(this);
+    typeCombo->addItem("All types", -1);
+    typeCombo->addItem("Food", int(ItemType::Food));
+    typeCombo->addItem("Weapon", int(ItemType::Weapon));
+    typeCombo->addItem("Shield", int(ItemType::Shield));
+    typeCombo->addItem("Monster", int(ItemType::Monster));
+    typeCombo->addItem("Misc", int(ItemType::Misc));
+    filterRow->addWidget(typeCombo);
+
+    tagCombo = new QComboBox(this);
+    tagCombo->addItem("All tags", QString());
+    filterRow->addWidget(tagCombo);
+
+    root->addLayout(filterRow);
+
+    model = new InventoryModel(this);
+
+    view = new QListView(this);
+    view->setViewMode(QListView::IconMode);
+    view->setResizeMode(QListView::Adjust);
+    view->setMovement(QListView::Static);
+    view->setUniformItemSizes(true); // 布局不用逐项问 sizeHint，上万项也是 O(1)
+    view->setSpacing(4);
+    view->setSelectionMode(QAbstractItemView::NoSelection);
+    view->setMouseTracking(true);
+    view->setModel(model);
+    view->setItemDelegate(new InventoryDelegate(model, view));
+    root->addWidget(view, 1);
+
+    connect(view, &QListView::clicked, this, [this](const QModelIndex &idx)
+            {
+        const int handle = model->handleAt(idx.row());
+        if (handle >= 0)
+            emit spawnRequested(handle); });
+
+    connect(searchEdit, &QLineEdit::textChanged, this, [this]()
+            { applyFilter(); });
+    connect(typeCombo, &QComboBox::currentIndexChanged, this, [this]()
+            { applyFilter(); });
+    connect(tagCombo, &QComboBox::currentIndexChanged, this, [this]()
+            { applyFilter(); });
+
+    connect(&animTimer, &QTimer::timeout, this, [this]()
+            { animateVisible(); });
+    connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, this, [this]()
+            {
+        if (isVisible())
+            PowerPolicy::instance().drive(animTimer, animIntervalMs); });
 }
 
-void InventoryDialog::setDB(ItemDB *db)
+void InventoryDialog::setCatalog(const ItemCatalogPtr &catalog)
 {
-    db_ = db;
-    rebuildUI();
+    catalog_ = catalog;
+    model->setCatalog(catalog);
+    refreshTagCombo();
+    applyFilter();
 }
 
-void InventoryDialog::rebuildUI()
+void InventoryDialog::refreshTagCombo()
 {
-    auto *scroll = findChild<QScrollArea *>();
-    if (!scroll)
-        return;
-    auto *container = scroll->widget();
-    if (!container)
-        return;
-    auto *grid = qobject_cast<QGridLayout *>(container->layout());
-    if (!grid)
-        return;
+    const QString current = tagCombo->currentData().toString();
 
-    while (grid->count() > 0)
+    QSignalBlocker block(tagCombo);
+    tagCombo->clear();
+    tagCombo->addItem("All tags", QString());
+    if (catalog_)
     {
-        auto *it = grid->takeAt(0);
-        if (it->widget())
-            it->widget()->deleteLater();
-        delete it;
+        for (const auto &tag : catalog_->allTags())
+            tagCombo->addItem(tag, tag);
     }
+    const int idx = tagCombo->findData(current);
+    tagCombo->setCurrentIndex(idx < 0 ? 0 : idx);
+}
 
-    if (!db_)
+void InventoryDialog::applyFilter()
+{
+    if (!catalog_)
         return;
 
-    const auto ids = db_->itemIds();
-    const int columns = 4;
-    int row = 0, col = 0;
+    ItemQuery q;
+    q.text = searchEdit->text();
+    q.type = typeCombo->currentData().toInt();
+    q.tag = tagCombo->currentData().toString();
 
-    for (const auto &id : ids)
-    {
-        const ItemDef *def = db_->get(id);
-        if (!def)
-            continue;
+    const bool noFilter = q.text.trimmed().isEmpty() && q.type < 0 && q.tag.isEmpty();
+    model->setFilter(noFilter ? QBitArray() : catalog_->match(q));
+}
 
-        auto *btn = new AnimatedItemButton(def->id, def->frames, def->frameIntervalMs, container);
-        btn->setToolTip(def->name);
+void InventoryDialog::showEvent(QShowEvent *e)
+{
+    QDialog::showEvent(e);
+    PowerPolicy::instance().drive(animTimer, animIntervalMs);
+}
 
-        connect(btn, &QPushButton::clicked, this, [this, id]()
-                { emit spawnRequested(id); });
+void InventoryDialog::hideEvent(QHideEvent *e)
+{
+    animTimer.stop();
+    QDialog::hideEvent(e);
+}
 
-        grid->addWidget(btn, row, col);
+void InventoryDialog::animateVisible()
+{
+    if (!view || model->rowCount() == 0)
+        return;
 
-        col++;
-        if (col >= columns)
-        {
-            col = 0;
-            row++;
-        }
+    // IconMode + LeftToRight：视口内的格子在模型里是连续的一段，
+    // 从左上角那格开始往后走，直到格子顶端超出视口为止。
+    // 顶部可能正好是格子间隙，沿第一列往下探几次。
+    const QRect vp = view->viewport()->rect();
+    const int probeX = view->spacing() + InventoryDelegate::kCellSize / 2;
+    QModelIndex idx;
+    for (int y = 0; y <= InventoryDelegate::kCellSize && !idx.isValid(); y += 8)
+        idx = view->indexAt(QPoint(probeX, y));
+    int row = idx.isValid() ? idx.row() : 0;
+
+    for (; row < model->rowCount(); ++row)
+    {
+        const QModelIndex i = model->index(row);
+        const QRect r = view->visualRect(i);
+        if (r.top() > vp.bottom())
+            break;
+        if (r.intersects(vp) && i.data(InventoryModel::AnimatedRole).toBool())
+            view->viewport()->update(r);
     }
-
-    grid->setRowStretch(row + 1, 1);
 }
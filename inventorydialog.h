@@ -1,8 +1,14 @@
 #pragma once
 #include <QDialog>
 #include <QString>
+#include <QTimer>
 
-class ItemDB;
+#include "itemdb.h"
+
+class QListView;
+class QLineEdit;
+class QComboBox;
+class InventoryModel;
 
 class InventoryDialog : public QDialog
 {
@@ -10,12 +16,32 @@ class InventoryDialog : public QDialog
 public:
     explicit InventoryDialog(QWidget *parent = nullptr);
 
-    void setDB(ItemDB *db);
+    // 首次设置或 ItemDB 发布新快照后调用：模型做增量更新，不重建视图。
+    // 对话框持有这份快照，直到下一次 setCatalog
+    void setCatalog(const ItemCatalogPtr &catalog);
 
 signals:
-    void spawnRequested(const QString &itemId);
+    void spawnRequested(int itemHandle); // itemIdTable() 句柄
+
+protected:
+    void showEvent(QShowEvent *e) override;
+    void hideEvent(QHideEvent *e) override;
 
 private:
-    ItemDB *db_ = nullptr;
-    void rebuildUI();
+    ItemCatalogPtr catalog_;
+    InventoryModel *model = nullptr;
+    QListView *view = nullptr;
+
+    // 搜索/过滤：每次变化都是 ItemCatalog::match() 的几次位图求交，再对模型做增量 diff
+    QLineEdit *searchEdit = nullptr;
+    QComboBox *typeCombo = nullptr;
+    QComboBox *tagCombo = nullptr;
+    void refreshTagCombo();
+    void applyFilter();
+
+    // 所有格子共用的动画节拍：只在对话框可见时运行，每次只重画视口内有动画的格子；
+    // 间隔跟随 PowerPolicy 档位
+    QTimer animTimer;
+    static constexpr int animIntervalMs = 40;
+    void animateVisible();
 };
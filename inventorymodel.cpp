@@ -0,0 +1,159 @@
+#include "inventorymodel.h"
+
+#include <QPainter>
+#include <QApplication>
+#include <QStyle>
+#include <algorithm>
+
+InventoryModel::InventoryModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void InventoryModel::setCatalog(const ItemCatalogPtr &catalog)
+{
+    // 行只存句柄和 id，换快照后归并 diff 照常成立；过滤位图按旧快照的 rank 编号，需重新给
+    if (catalog != catalog_)
+        filter.clear();
+    catalog_ = catalog;
+    sync();
+}
+
+void InventoryModel::setFilter(const QBitArray &rankMask)
+{
+    filter = rankMask;
+    rebuildRows(); // 只是行集合变化，不需要通知数据变更
+}
+
+void InventoryModel::sync()
+{
+    rebuildRows();
+
+    // 保留下来的行帧数据可能已更新，只通知一次，视图只重画可见格
+    if (!rows.isEmpty())
+        emit dataChanged(index(0), index(rows.size() - 1));
+}
+
+void InventoryModel::rebuildRows()
+{
+    // 目标行：按 rank（即 id 顺序）过一遍位图
+    QVector<QString> ids;
+    QVector<int> handles;
+    if (catalog_)
+    {
+        const auto &all = catalog_->itemIds();
+        const bool filtered = filter.size() == all.size();
+        for (int rank = 0; rank < all.size(); ++rank)
+        {
+            if (filtered && !filter.testBit(rank))
+                continue;
+            ids.push_back(all[rank]);
+            handles.push_back(catalog_->atRank(rank)->handle);
+        }
+    }
+
+    // 两个有序列表做归并：旧有新无 -> remove，旧无新有 -> insert，连续的一段合并成一次通知
+    int row = 0;
+    int n = 0;
+    while (row < rowIds.size() || n < ids.size())
+    {
+        int r = row;
+        while (r < rowIds.size() && (n >= ids.size() || rowIds[r] < ids[n]))
+            ++r;
+        if (r > row)
+        {
+            beginRemoveRows(QModelIndex(), row, r - 1);
+            rows.remove(row, r - row);
+            rowIds.remove(row, r - row);
+            endRemoveRows();
+            continue;
+        }
+
+        int m = n;
+        while (m < ids.size() && (row >= rowIds.size() || ids[m] < rowIds[row]))
+            ++m;
+        if (m > n)
+        {
+            beginInsertRows(QModelIndex(), row, row + (m - n) - 1);
+            rows = rows.mid(0, row) + handles.mid(n, m - n) + rows.mid(row);
+            rowIds = rowIds.mid(0, row) + ids.mid(n, m - n) + rowIds.mid(row);
+            endInsertRows();
+            row += m - n;
+            n = m;
+            continue;
+        }
+
+        // 两边相同：保留
+        rows[row] = handles[n];
+        ++row;
+        ++n;
+    }
+}
+
+int InventoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+QVariant InventoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!catalog_ || !index.isValid() || index.row() >= rows.size())
+        return {};
+
+    const ItemDef *def = catalog_->get(rows[index.row()]);
+    if (!def)
+        return {};
+
+    switch (role)
+    {
+    case Qt::ToolTipRole:
+        return def->name;
+    case HandleRole:
+        return def->handle;
+    case AnimatedRole:
+        return def->frames.size() > 1;
+    default:
+        return {};
+    }
+}
+
+InventoryDelegate::InventoryDelegate(const InventoryModel *model, QObject *parent)
+    : QStyledItemDelegate(parent), model_(model)
+{
+    clock.start();
+}
+
+QSize InventoryDelegate::sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const
+{
+    return QSize(kCellSize, kCellSize);
+}
+
+void InventoryDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    // 背景/hover/选中态交给 style 画，保持和普通列表一致
+    QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &option, painter, option.widget);
+
+    const ItemDef *def = model_->catalog() ? model_->catalog()->get(model_->handleAt(index.row())) : nullptr;
+    if (!def || !def->clip || def->frames.isEmpty())
+        return;
+
+    const int idx = frameAtTime(def->frames, clock.elapsed(), std::max(1, def->frameIntervalMs));
+    const SpriteFrame &f = def->frames[idx];
+
+    // 整个画布缩放到 kIconSize 格子里，裁剪后的帧按 offset 落在画布对应位置
+    QRect target(QPoint(0, 0), QSize(kIconSize, kIconSize));
+    target.moveCenter(option.rect.center());
+    const QSize canvas = def->clip->canvas;
+    const qreal sx = qreal(kIconSize) / std::max(1, canvas.width());
+    const qreal sy = qreal(kIconSize) / std::max(1, canvas.height());
+    const QRectF dst(target.left() + f.offset.x() * sx,
+                     target.top() + f.offset.y() * sy,
+                     f.pixmap.width() * sx,
+                     f.pixmap.height() * sy);
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->drawPixmap(dst, f.pixmap, QRectF(f.pixmap.rect()));
+    painter->restore();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QString>
+#include <QBitArray>
+
+#include "itemdb.h"
+
+// InventoryModel
+// 每行一个物品（按 id 排序），只保存 item 句柄；帧数据每次从持有的目录快照取。
+// setCatalog / sync / setFilter 做增量 diff：只对增删的连续区间发 insert/remove，不整体 reset。
+class InventoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles
+    {
+        HandleRole = Qt::UserRole + 1, // itemIdTable() 句柄
+        AnimatedRole                   // 帧数 > 1
+    };
+
+    explicit InventoryModel(QObject *parent = nullptr);
+
+    // 换成新快照（ItemDB 重新加载后）：按 id 做增量 diff，旧快照随之释放
+    void setCatalog(const ItemCatalogPtr &catalog);
+    void sync();
+
+    // ItemCatalog::match() 的结果；空位图表示不过滤
+    void setFilter(const QBitArray &rankMask);
+
+    const ItemCatalog *catalog() const { return catalog_.get(); }
+    int handleAt(int row) const { return rows.value(row, -1); }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    ItemCatalogPtr catalog_;
+    QVector<int> rows;       // item 句柄
+    QVector<QString> rowIds; // 与 rows 对齐的 id，用于有序 diff
+    QBitArray filter;
+
+    void rebuildRows();
+};
+
+// InventoryDelegate
+// 只负责画单元格：当前帧由共享时钟推算（elapsed / frameIntervalMs），
+// 所以不需要每个物品一个 QTimer，没滚进视口的格子也不会被画。
+class InventoryDelegate : public QStyledItemDelegate
+{
+public:
+    explicit InventoryDelegate(const InventoryModel *model, QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    static constexpr int kCellSize = 72;
+    static constexpr int kIconSize = 56;
+
+private:
+    const InventoryModel *model_;
+    QElapsedTimer clock;
+};
@@ -6,25 +6,17 @@
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonValue>
-#include <QPainter>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QColor>
 #include <algorithm>
+#include <cmath>
+#include <utility>
 
-static QPixmap normalizeFrame(const QPixmap &src, const QSize &targetSize)
-{
-    if (src.isNull())
-        return QPixmap();
-    QPixmap scaled = src.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-    QPixmap canvas(targetSize);
-    canvas.fill(Qt::transparent);
-    QPainter p(&canvas);
-    int x = (targetSize.width() - scaled.width()) / 2;
-    int y = (targetSize.height() - scaled.height()) / 2;
-    p.drawPixmap(x, y, scaled);
-    return canvas;
-}
+#include "metrics.h"
 
-ItemType ItemDB::parseType(const QString &s)
+ItemType ItemCatalog::parseType(const QString &s)
 {
     const QString t = s.trimmed().toLower();
     if (t == "food")
@@ -38,10 +30,154 @@ ItemType ItemDB::parseType(const QString &s)
     return ItemType::Misc;
 }
 
-ItemDef ItemDB::loadOneItemDir(const QString &id, const QString &dirPath, const QSize &targetSize)
+const char *itemTypeName(ItemType t)
+{
+    switch (t)
+    {
+    case ItemType::Food:
+        return "food";
+    case ItemType::Weapon:
+        return "weapon";
+    case ItemType::Shield:
+        return "shield";
+    case ItemType::Monster:
+        return "monster";
+    case ItemType::Misc:
+        break;
+    }
+    return "misc";
+}
+
+ItemEvent parseItemEvent(const QString &s)
+{
+    static const char *const names[kItemEventCount] = {
+        "actor_use",
+        "item_use",
+        "item_spawn",
+        "actor_spawn",
+        "enemy_spawn",
+        "enemy_hit",
+        "enemy_attack",
+        "enemy_death",
+    };
+    for (int i = 0; i < kItemEventCount; ++i)
+        if (s == QLatin1String(names[i]))
+            return ItemEvent(i);
+    return ItemEvent::Count;
+}
+
+namespace
+{
+    // 已知 stat：manifest key -> ItemStats 字段（都是整数）
+    struct KnownStat
+    {
+        const char *key;
+        int ItemStats::*field;
+    };
+
+    const KnownStat kKnownStats[] = {
+        {"hp", &ItemStats::hp},
+        {"damage", &ItemStats::damage},
+        {"heal", &ItemStats::heal},
+        {"defense", &ItemStats::defense},
+        {"speed", &ItemStats::speed},
+        {"cooldown_ms", &ItemStats::cooldownMs},
+    };
+}
+
+ItemStats ItemCatalog::compileStats(const QString &id, const QJsonObject &o)
+{
+    ItemStats st;
+    for (auto it = o.begin(); it != o.end(); ++it)
+    {
+        const QString key = it.key();
+        const QJsonValue v = it.value();
+
+        const KnownStat *known = nullptr;
+        for (const auto &k : kKnownStats)
+        {
+            if (key == QLatin1String(k.key))
+            {
+                known = &k;
+                break;
+            }
+        }
+
+        if (!v.isDouble())
+        {
+            report << QString("%1: stat \"%2\" is not a number, ignored").arg(id, key);
+            continue;
+        }
+
+        const double d = v.toDouble();
+        if (known)
+        {
+            if (d != std::floor(d))
+                report << QString("%1: stat \"%2\" should be an integer, got %3 (truncated)").arg(id, key).arg(d);
+            st.*(known->field) = int(d);
+        }
+        else
+        {
+            report << QString("%1: unknown stat \"%2\" kept in extra").arg(id, key);
+            st.extra.push_back({statKeys.intern(key), d});
+        }
+    }
+    return st;
+}
+
+EffectDef ItemCatalog::compileEffect(const QString &id, const QString &event, const QJsonValue &v)
+{
+    // 字符串 = 预设名；对象 = 预设（可省略，默认 crumbs）+ 覆盖字段，color 可带 alpha（#AARRGGBB）
+    if (v.isString())
+    {
+        const EffectDef d = EffectDef::preset(v.toString());
+        if (d.isNull())
+            report << QString("%1: effect \"%2\" uses unknown preset \"%3\", ignored").arg(id, event, v.toString());
+        return d;
+    }
+    if (!v.isObject())
+    {
+        report << QString("%1: effect \"%2\" is not a string or object, ignored").arg(id, event);
+        return EffectDef();
+    }
+
+    const QJsonObject o = v.toObject();
+    const QString presetName = o.value("preset").toString("crumbs");
+    EffectDef d = EffectDef::preset(presetName);
+    if (d.isNull())
+    {
+        report << QString("%1: effect \"%2\" uses unknown preset \"%3\", ignored").arg(id, event, presetName);
+        return d;
+    }
+
+    if (o.value("count").isDouble())
+        d.count = std::clamp(o.value("count").toInt(), 0, 256);
+    if (o.value("color").isString())
+    {
+        const QColor c(o.value("color").toString());
+        if (c.isValid())
+            d.color = c.rgba();
+        else
+            report << QString("%1: effect \"%2\" has invalid color, ignored").arg(id, event);
+    }
+    const std::pair<const char *, float EffectDef::*> floats[] = {
+        {"speed", &EffectDef::speed},
+        {"spread", &EffectDef::spread},
+        {"life_ms", &EffectDef::lifeMs},
+        {"size", &EffectDef::size},
+        {"gravity", &EffectDef::gravity},
+    };
+    for (const auto &f : floats)
+        if (o.value(f.first).isDouble())
+            d.*(f.second) = float(o.value(f.first).toDouble());
+    return d;
+}
+
+ItemDef ItemCatalog::parseManifest(const QString &id, const QString &dirPath)
 {
     ItemDef def;
     def.id = id;
+    def.handle = itemIdTable().intern(id);
     def.name = id;
     def.type = ItemType::Misc;
 
@@ -70,7 +206,9 @@ ItemDef ItemDB::loadOneItemDir(const QString &id, const QString &dirPath, const
                 }
 
                 if (o.contains("stats") && o["stats"].isObject())
-                    def.stats = o["stats"].toObject();
+                    def.stats = compileStats(id, o["stats"].toObject());
+                else if (o.contains("stats"))
+                    report << QString("%1: \"stats\" is not an object, ignored").arg(id);
 
                 // audio: { "actor_use": "eat", "item_use": "apple_use", "enemy_hit": "slime_hit", ... }
                 if (o.contains("audio") && o["audio"].isObject())
@@ -78,8 +216,30 @@ ItemDef ItemDB::loadOneItemDir(const QString &id, const QString &dirPath, const
                     const QJsonObject a = o["audio"].toObject();
                     for (auto it = a.begin(); it != a.end(); ++it)
                     {
+                        const ItemEvent ev = parseItemEvent(it.key());
+                        if (ev == ItemEvent::Count)
+                        {
+                            report << QString("%1: unknown audio event \"%2\", ignored").arg(id, it.key());
+                            continue;
+                        }
                         if (it.value().isString())
-                            def.audio.insert(it.key(), it.value().toString());
+                            def.audio[size_t(ev)] = audioCategoryTable().intern(it.value().toString());
+                    }
+                }
+
+                // effects: { "actor_use": "crumbs", "enemy_hit": { "preset": "sparks", "color": "#80ff80" }, ... }
+                if (o.contains("effects") && o["effects"].isObject())
+                {
+                    const QJsonObject e = o["effects"].toObject();
+                    for (auto it = e.begin(); it != e.end(); ++it)
+                    {
+                        const ItemEvent ev = parseItemEvent(it.key());
+                        if (ev == ItemEvent::Count)
+                        {
+                            report << QString("%1: unknown effect event \"%2\", ignored").arg(id, it.key());
+                            continue;
+                        }
+                        def.effects[size_t(ev)] = compileEffect(id, it.key(), it.value());
                     }
                 }
 
@@ -89,56 +249,262 @@ ItemDef ItemDB::loadOneItemDir(const QString &id, const QString &dirPath, const
         }
     }
 
-    // 2) 读 png 帧
-    QDir dir(dirPath);
-    QFileInfoList files = dir.entryInfoList({"*.png", "*.PNG"}, QDir::Files, QDir::Name);
-    for (const auto &fi : files)
+    return def;
+}
+
+ItemDB::ItemDB(QObject *parent)
+    : QObject(parent)
+{
+    auto empty = std::make_shared<ItemCatalog>();
+    empty->buildIndex();
+    current = std::move(empty);
+}
+
+ItemDB::~ItemDB()
+{
+    ++generation; // 还没送到的结果不再发布
+    for (QThread *t : builders)
     {
-        QPixmap raw(fi.absoluteFilePath());
-        QPixmap norm = normalizeFrame(raw, targetSize);
-        if (!norm.isNull())
-            def.frames.push_back(norm);
+        t->wait();
+        delete t;
     }
+}
 
-    return def;
+// 工作线程的产物：定义和索引已经完整，帧还是 QImage（QPixmap 只能在 GUI 线程创建）
+struct ItemDB::Build
+{
+    std::shared_ptr<ItemCatalog> catalog;
+    QStringList dirs;                        // 与 catalog->defs 对齐
+    QVector<AssetStore::DecodedClip> clips;  // 同上
+    QSize targetSize;
+    qint64 busyNs = 0; // 工作线程构建 + GUI 线程放帧池，累计
+    int adopted = 0;   // 已放进帧池的 def 数
+};
+
+std::shared_ptr<ItemDB::Build> ItemDB::build(const QString &assetsRoot, const QSize &targetSize)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    auto b = std::make_shared<Build>();
+    b->catalog = std::make_shared<ItemCatalog>();
+    b->targetSize = targetSize;
+    ItemCatalog &cat = *b->catalog;
+
+    const QDir itemsDir(QDir(assetsRoot).filePath("items"));
+    if (!assetsRoot.isEmpty() && itemsDir.exists())
+    {
+        const QFileInfoList dirs = itemsDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const auto &d : dirs)
+        {
+            ItemDef def = cat.parseManifest(d.fileName(), d.absoluteFilePath());
+            AssetStore::DecodedClip decoded = AssetStore::decode(d.absoluteFilePath(), targetSize);
+            if (decoded.images.isEmpty()) // 没帧就忽略
+                continue;
+
+            if (def.handle >= cat.slotByHandle.size())
+                cat.slotByHandle.resize(def.handle + 1, -1);
+            cat.slotByHandle[def.handle] = cat.defs.size();
+            cat.defs.push_back(def);
+            b->dirs.push_back(d.absoluteFilePath());
+            b->clips.push_back(std::move(decoded));
+        }
+    }
+    cat.buildIndex();
+
+    b->busyNs = clock.nsecsElapsed();
+    return b;
+}
+
+bool ItemDB::adopt(Build &b, int maxDefs)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    // 像素进帧池（经 AssetStore，同目录同尺寸已经在用的 clip 直接复用）
+    ItemCatalog &cat = *b.catalog;
+    const int end = std::min<qint64>(cat.defs.size(), qint64(b.adopted) + maxDefs);
+    for (int i = b.adopted; i < end; ++i)
+    {
+        ItemDef &def = cat.defs[i];
+        def.clip = AssetStore::instance().adopt(b.dirs[i], b.targetSize, b.clips[i]);
+        if (def.clip)
+            def.frames = def.clip->frames;
+        b.clips[i] = AssetStore::DecodedClip(); // 放完就释放 QImage
+    }
+    b.adopted = end;
+
+    b.busyNs += clock.nsecsElapsed();
+    return b.adopted == cat.defs.size();
+}
+
+void ItemDB::adoptStep(const std::shared_ptr<Build> &b, quint64 gen,
+                       const std::function<void(const ItemCatalogPtr &)> &done)
+{
+    if (gen != generation)
+        return; // 之后又发起了加载，这份结果已过期
+
+    if (!adopt(*b, kAdoptPerTurn))
+    {
+        // 还没放完：排到下一个回合，中间让输入和绘制先跑
+        QMetaObject::invokeMethod(this, [this, b, gen, done]()
+                                  { adoptStep(b, gen, done); }, Qt::QueuedConnection);
+        return;
+    }
+
+    publish(*b);
+    if (done)
+        done(current);
+    notifyWaiters();
+}
+
+void ItemDB::publish(Build &b)
+{
+    pending = false;
+    published = true;
+    b.clips.clear();
+    ItemCatalog &cat = *b.catalog;
+
+    // 一次性替换：旧快照在最后一个读者放手时释放
+    std::atomic_store(&current, ItemCatalogPtr(b.catalog));
+
+    for (const auto &line : cat.loadReport())
+        qWarning() << "ItemDB:" << line;
+
+    Metrics &m = Metrics::instance();
+    m.gaugeSeconds("expldy_itemdb_load_seconds", "Time spent building the catalog (worker decode + frame pool upload)")
+        .store(b.busyNs / 1000, std::memory_order_relaxed);
+    m.gauge("expldy_itemdb_items", "Items in the published catalog").store(cat.size(), std::memory_order_relaxed);
 }
 
 bool ItemDB::load(const QString &assetsRoot, const QSize &targetSize)
 {
-    items.clear();
-    if (assetsRoot.isEmpty())
-        return false;
+    ++generation;
+    std::shared_ptr<Build> b = build(assetsRoot, targetSize);
+    adopt(*b, b->catalog->defs.size());
+    publish(*b);
+    notifyWaiters();
+    return current->size() > 0;
+}
+
+void ItemDB::loadAsync(const QString &assetsRoot, const QSize &targetSize,
+                       std::function<void(const ItemCatalogPtr &)> done)
+{
+    const quint64 gen = ++generation;
+    pending = true;
+    QThread *t = QThread::create([this, assetsRoot, targetSize, gen, done]()
+                                 {
+        std::shared_ptr<Build> b = build(assetsRoot, targetSize);
+        QMetaObject::invokeMethod(this, [this, b, gen, done]()
+                                  {
+            if (gen != generation)
+                return; // 之后又发起了加载，这份结果已过期
+            adoptStep(b, gen, done); }, Qt::QueuedConnection); });
+    builders.push_back(t);
+    connect(t, &QThread::finished, this, [this, t]()
+            {
+        builders.removeOne(t);
+        t->deleteLater(); });
+    t->start(QThread::LowPriority);
+}
+
+void ItemDB::whenReady(QObject *context, std::function<void(const ItemCatalogPtr &)> fn)
+{
+    if (published && !pending)
+    {
+        // 和加载完成的回调一样异步：调用方不用区分“已经好了”和“稍后才好”
+        QMetaObject::invokeMethod(context, [fn = std::move(fn), catalog = current]()
+                                  { fn(catalog); }, Qt::QueuedConnection);
+        return;
+    }
+    waiters.push_back({context, std::move(fn)});
+}
+
+void ItemDB::notifyWaiters()
+{
+    const QVector<Waiter> ready = std::exchange(waiters, {});
+    const ItemCatalogPtr catalog = current;
+    for (const Waiter &w : ready)
+    {
+        if (w.context)
+            w.fn(catalog);
+    }
+}
 
-    QDir itemsDir(QDir(assetsRoot).filePath("items"));
-    if (!itemsDir.exists())
-        return false;
+void ItemCatalog::buildIndex()
+{
+    const int n = defs.size();
+
+    sortedSlots.resize(n);
+    for (int i = 0; i < n; ++i)
+        sortedSlots[i] = i;
+    std::sort(sortedSlots.begin(), sortedSlots.end(), [this](int a, int b)
+              { return defs[a].id < defs[b].id; });
 
-    const auto dirs = itemsDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-    for (const auto &d : dirs)
+    sortedIds.clear();
+    sortedIds.reserve(n);
+    prefixKeys.clear();
+    tagPostings.clear();
+    for (auto &bits : typePostings)
+        bits = QBitArray(n);
+
+    for (int rank = 0; rank < n; ++rank)
     {
-        const QString id = d.fileName();
-        const QString dirPath = d.absoluteFilePath();
+        const ItemDef &def = defs[sortedSlots[rank]];
+        sortedIds.push_back(def.id);
+
+        // id 整体 + name 的每个词都可以作为前缀命中
+        prefixKeys.push_back({def.id.toLower(), rank});
+        const QStringList words = def.name.toLower().split(' ', Qt::SkipEmptyParts);
+        for (const auto &w : words)
+            prefixKeys.push_back({w, rank});
 
-        ItemDef def = loadOneItemDir(id, dirPath, targetSize);
-        if (def.frames.isEmpty())
-            continue; // 没帧就忽略
-        items.insert(id, def);
+        typePostings[size_t(def.type)].setBit(rank);
+
+        for (const auto &tag : def.tags)
+        {
+            auto it = tagPostings.find(tag);
+            if (it == tagPostings.end())
+                it = tagPostings.insert(tag, QBitArray(n));
+            it->setBit(rank);
+        }
     }
 
-    return !items.isEmpty();
+    std::sort(prefixKeys.begin(), prefixKeys.end());
+
+    sortedTags = tagPostings.keys();
+    std::sort(sortedTags.begin(), sortedTags.end());
 }
 
-QVector<QString> ItemDB::itemIds() const
+QBitArray ItemCatalog::prefixMatch(const QString &prefix) const
 {
-    auto keys = items.keys().toVector();
-    std::sort(keys.begin(), keys.end());
-    return keys;
+    QBitArray bits(sortedIds.size());
+    auto it = std::lower_bound(prefixKeys.begin(), prefixKeys.end(), prefix,
+                               [](const QPair<QString, int> &k, const QString &p)
+                               { return k.first < p; });
+    for (; it != prefixKeys.end() && it->first.startsWith(prefix); ++it)
+        bits.setBit(it->second);
+    return bits;
+}
+
+QBitArray ItemCatalog::match(const ItemQuery &q) const
+{
+    QBitArray bits(sortedIds.size(), true);
+
+    const QStringList words = q.text.toLower().split(' ', Qt::SkipEmptyParts);
+    for (const auto &w : words)
+        bits &= prefixMatch(w);
+
+    if (q.type >= 0 && q.type < kItemTypeCount)
+        bits &= typePostings[size_t(q.type)];
+
+    if (!q.tag.isEmpty())
+        bits &= tagPostings.value(q.tag, QBitArray(sortedIds.size()));
+
+    return bits;
 }
 
-const ItemDef *ItemDB::get(const QString &id) const
+const ItemDef *ItemCatalog::get(const QString &id) const
 {
-    auto it = items.find(id);
-    if (it == items.end())
-        return nullptr;
-    return &it.value();
+    return get(itemIdTable().find(id));
 }
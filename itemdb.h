@@ -5,6 +5,22 @@
 #include <QPixmap>
 #include <QHash>
 #include <QJsonObject>
+#include <QJsonValue>
+#include <QPair>
+#include <QBitArray>
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "interner.h"
+#include "assetstore.h"
+#include "effectdef.h"
+
+class QThread;
 
 enum class ItemType
 {
@@ -15,30 +31,203 @@ enum class ItemType
     Misc
 };
 
+// manifest.audio 支持的事件。加载时把 key 解析成枚举，运行时按下标取 category 句柄
+enum class ItemEvent
+{
+    ActorUse,
+    ItemUse,
+    ItemSpawn,
+    ActorSpawn,
+    EnemySpawn,
+    EnemyHit,
+    EnemyAttack,
+    EnemyDeath,
+    Count
+};
+
+constexpr int kItemEventCount = int(ItemEvent::Count);
+
+// ItemType::Food -> "food"（与 manifest.type 的写法一致）
+const char *itemTypeName(ItemType t);
+
+// "actor_use" -> ItemEvent::ActorUse；不认识返回 ItemEvent::Count
+ItemEvent parseItemEvent(const QString &s);
+
+// manifest.stats 编译后的定长结构：战斗/回复逻辑直接读字段，不再走 JSON 字符串查表
+struct ItemStats
+{
+    int hp = 0;         // 怪物血量
+    int damage = 0;     // 武器/怪物伤害
+    int heal = 0;       // 食物回复量
+    int defense = 0;    // 盾牌减伤
+    int speed = 0;      // 移动/攻击速度（预留）
+    int cooldownMs = 0; // cooldown_ms
+
+    // 未识别的数值 key：(ItemCatalog::statKeyId, value)。通常只有 0-2 项，线性查找即可
+    QVector<QPair<int, double>> extra;
+
+    double extraValue(int keyId, double fallback = 0.0) const
+    {
+        for (const auto &kv : extra)
+            if (kv.first == keyId)
+                return kv.second;
+        return fallback;
+    }
+};
+
 struct ItemDef
 {
-    QString id;   // 文件夹名
-    QString name; // manifest.name 或 id
+    QString id;       // 文件夹名
+    int handle = -1;  // itemIdTable() 里的句柄
+    QString name;     // manifest.name 或 id
     ItemType type = ItemType::Misc;
-    QStringList tags;  // manifest.tags
-    QJsonObject stats; // manifest.stats（先存 JSON 方便扩展）
-    // manifest.audio：事件 -> category（不限定 key，阶段2会用到 actor_use/item_use/enemy_* 等）
-    QHash<QString, QString> audio;
-    QVector<QPixmap> frames;   // 已缩放到 targetSize 的帧
+    QStringList tags; // manifest.tags
+    ItemStats stats;  // manifest.stats（加载时编译）
+    // manifest.audio：事件 -> category 句柄（audioCategoryTable()），未配置为 -1
+    std::array<int, kItemEventCount> audio;
+    // manifest.effects：事件 -> 粒子发射配置，未配置为空（count = 0）
+    std::array<EffectDef, kItemEventCount> effects;
+    ClipHandle clip;           // AssetStore 共享的帧（多个 ItemDB 只解码一次）
+    SpriteFrames frames;       // = clip->frames，隐式共享，不占额外内存
     int frameIntervalMs = 120; // manifest.frame_interval_ms 或默认
+
+    ItemDef() { audio.fill(-1); }
+
+    int audioFor(ItemEvent e) const { return audio[size_t(e)]; }
+    const EffectDef &effectFor(ItemEvent e) const { return effects[size_t(e)]; }
 };
 
-class ItemDB
+constexpr int kItemTypeCount = int(ItemType::Misc) + 1;
+
+// Inventory 搜索条件：text 按空白拆成若干前缀（都要命中 name 或 id 的某个词），
+// type < 0 / tag 为空表示不过滤
+struct ItemQuery
+{
+    QString text;
+    int type = -1;
+    QString tag;
+};
+
+// ItemCatalog
+// 一次加载的完整结果，发布后不可变：物品定义 + 搜索索引。
+// 读者通过 ItemCatalogPtr 持有快照，持有期间里面的 ItemDef 指针一直有效，重新加载不会影响它。
+// 快照里的 clip 析构时要归还帧池，所以最后一个引用应在 GUI 线程释放。
+class ItemCatalog
 {
 public:
-    bool load(const QString &assetsRoot, const QSize &targetSize);
+    // 已排序（load 时建好，不再每次拷贝+排序）。下标即“rank”，与 match() 的位对应
+    const QVector<QString> &itemIds() const { return sortedIds; }
+    const ItemDef *atRank(int rank) const { return &defs[sortedSlots[rank]]; }
+    int size() const { return defs.size(); }
 
-    QVector<QString> itemIds() const; // 已排序
+    // 返回长度为 itemIds().size() 的位图：第 rank 位为 1 表示命中
+    QBitArray match(const ItemQuery &q) const;
+    const QStringList &allTags() const { return sortedTags; } // 已排序
     const ItemDef *get(const QString &id) const;
+    const ItemDef *get(int handle) const
+    {
+        const int slot = (handle >= 0 && handle < slotByHandle.size()) ? slotByHandle[handle] : -1;
+        return slot < 0 ? nullptr : &defs[slot];
+    }
+
+    // stats 里未识别 key 的 intern 表：key -> 小整数，找不到返回 -1
+    int statKeyId(const QString &key) const { return statKeys.find(key); }
+    QString statKeyName(int keyId) const { return statKeys.name(keyId); }
+
+    // 这次加载的问题清单（未知 stat、类型不对等），每条一行
+    const QStringList &loadReport() const { return report; }
 
 private:
-    QHash<QString, ItemDef> items;
+    friend class ItemDB;
+
+    QVector<ItemDef> defs;
+    QVector<int> slotByHandle; // item 句柄 -> defs 下标，-1 表示不存在
+
+    Interner statKeys;
+    QStringList report;
+
+    // 搜索索引（都按 rank 编号）
+    QVector<QString> sortedIds;
+    QVector<int> sortedSlots;                            // rank -> defs 下标
+    QVector<QPair<QString, int>> prefixKeys;             // (小写词, rank)，按词排序，前缀查询用二分
+    std::array<QBitArray, kItemTypeCount> typePostings;  // ItemType -> 位图
+    QHash<QString, QBitArray> tagPostings;               // tag -> 位图
+    QStringList sortedTags;
+
+    void buildIndex();
+    QBitArray prefixMatch(const QString &prefix) const;
 
     static ItemType parseType(const QString &s);
-    static ItemDef loadOneItemDir(const QString &id, const QString &dirPath, const QSize &targetSize);
+    ItemStats compileStats(const QString &id, const QJsonObject &o);
+    EffectDef compileEffect(const QString &id, const QString &event, const QJsonValue &v);
+    ItemDef parseManifest(const QString &id, const QString &dirPath);
+};
+
+using ItemCatalogPtr = std::shared_ptr<const ItemCatalog>;
+
+// ItemDB
+// 物品库的发布点：当前快照是一个原子替换的 shared_ptr。
+// 同一份素材的物品库由 AssetStore::itemDB() 在所有角色/前端之间共用，这里只加载一次。
+// - 新快照在工作线程上完整构建（读 manifest、解码 png、建索引），回到 GUI 线程只把像素放进帧池，然后一次性替换
+// - loadAsync 的像素分批放进帧池：每个事件循环回合最多 kAdoptPerTurn 个物品，全部放完才替换快照，
+//   物品再多也不会让 GUI 线程卡一整帧
+// - 读者用 snapshot() 拿到自己的引用，重新加载既不阻塞读者，也不会让读者手里的指针失效
+// - 下面的转发函数是 GUI 线程的便捷写法：返回的指针/引用在下一次发布（同在 GUI 线程）之前有效；
+//   要跨事件循环回合持有，请自己保留 snapshot()
+class ItemDB : public QObject
+{
+public:
+    explicit ItemDB(QObject *parent = nullptr);
+    ~ItemDB() override; // 等待仍在构建的快照
+
+    // 同步加载并发布（GUI 线程）
+    bool load(const QString &assetsRoot, const QSize &targetSize);
+
+    // 在工作线程构建，构建完成后在 GUI 线程发布并回调 done（参数为新快照）。
+    // 多次调用时只有最后一次的结果会发布
+    void loadAsync(const QString &assetsRoot, const QSize &targetSize,
+                   std::function<void(const ItemCatalogPtr &)> done = {});
+    bool isLoading() const { return pending; }
+
+    // 共用者登记“发布后通知我”：已经发布且没有在加载时，排到下一个回合回调当前快照；
+    // 否则等这次加载发布时回调。context 销毁后不再回调
+    void whenReady(QObject *context, std::function<void(const ItemCatalogPtr &)> fn);
+
+    static constexpr int kAdoptPerTurn = 8;
+
+    // 任何线程都可以调用
+    ItemCatalogPtr snapshot() const { return std::atomic_load(&current); }
+
+    const QVector<QString> &itemIds() const { return current->itemIds(); }
+    const ItemDef *atRank(int rank) const { return current->atRank(rank); }
+    QBitArray match(const ItemQuery &q) const { return current->match(q); }
+    const QStringList &allTags() const { return current->allTags(); }
+    const ItemDef *get(const QString &id) const { return current->get(id); }
+    const ItemDef *get(int handle) const { return current->get(handle); }
+    int statKeyId(const QString &key) const { return current->statKeyId(key); }
+    QString statKeyName(int keyId) const { return current->statKeyName(keyId); }
+    const QStringList &loadReport() const { return current->loadReport(); }
+
+private:
+    ItemCatalogPtr current; // 只在 GUI 线程替换；其他线程经 snapshot() 原子读取
+
+    struct Build;
+    static std::shared_ptr<Build> build(const QString &assetsRoot, const QSize &targetSize); // 任意线程
+    bool adopt(Build &b, int maxDefs);                                                      // GUI 线程；全部放完返回 true
+    void adoptStep(const std::shared_ptr<Build> &b, quint64 gen,
+                   const std::function<void(const ItemCatalogPtr &)> &done);               // 一个回合一批
+    void publish(Build &b);                                                                 // GUI 线程
+
+    quint64 generation = 0; // 每次加载 +1，过期的构建结果直接丢弃
+    bool pending = false;   // 最近一次 loadAsync 还没发布（构建中或正分批放进帧池）
+    bool published = false; // 发布过至少一次
+
+    struct Waiter
+    {
+        QPointer<QObject> context;
+        std::function<void(const ItemCatalogPtr &)> fn;
+    };
+    QVector<Waiter> waiters;
+    void notifyWaiters();
+    QList<QThread *> builders;
 };
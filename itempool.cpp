@@ -0,0 +1,89 @@
+#include "itempool.h"
+#include "itemwidget.h"
+#include "itemdb.h"
+
+#include <algorithm>
+
+ItemWidget *ItemPool::create(const ItemDef *def, QWidget *parent)
+{
+    auto *item = new ItemWidget(def->handle, def->clip, def->frameIntervalMs, parent);
+    if (onCreate)
+        onCreate(item);
+    return item;
+}
+
+ItemWidget *ItemPool::acquire(const ItemDef *def, QWidget *parent)
+{
+    if (!def)
+        return nullptr;
+
+    if (def->handle >= 0 && def->handle < buckets.size() && !buckets[def->handle].isEmpty())
+    {
+        ItemWidget *item = buckets[def->handle].takeLast();
+        --pooledCount;
+        ++hitCount;
+        if (item->parentWidget() != parent)
+            item->setParent(parent);
+        item->reset(def->handle, def->clip, def->frameIntervalMs);
+        return item;
+    }
+
+    ++missCount;
+    return create(def, parent);
+}
+
+void ItemPool::release(ItemWidget *item)
+{
+    if (!item)
+        return;
+
+    item->park();
+    item->hide();
+    item->setEquipped(false);
+
+    // 装备时是角色的子控件：放回顶层窗口，避免跟着角色一起被销毁
+    QWidget *top = item->window();
+    if (item->parentWidget() && item->parentWidget() != top)
+        item->setParent(top);
+
+    const int h = item->itemHandle();
+    if (h < 0)
+    {
+        item->deleteLater();
+        return;
+    }
+    if (h >= buckets.size())
+        buckets.resize(h + 1);
+    if (buckets[h].contains(item))
+        return;
+    if (buckets[h].size() >= maxPerItem || pooledCount >= maxPooled)
+    {
+        item->deleteLater();
+        return;
+    }
+    buckets[h].push_back(item);
+    ++pooledCount;
+}
+
+void ItemPool::prewarm(const ItemDef *def, QWidget *parent, int count)
+{
+    if (!def || def->handle < 0)
+        return;
+    if (def->handle >= buckets.size())
+        buckets.resize(def->handle + 1);
+
+    auto &bucket = buckets[def->handle];
+    while (bucket.size() < std::min(count, maxPerItem) && pooledCount < maxPooled)
+    {
+        ItemWidget *item = create(def, parent);
+        item->park();
+        item->hide();
+        bucket.push_back(item);
+        ++pooledCount;
+    }
+}
+
+QString ItemPool::report() const
+{
+    return QString("item pool hits=%1 misses=%2 pooled=%3").arg(hitCount).arg(missCount).arg(pooled());
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <QVector>
+#include <QWidget>
+#include <QString>
+#include <functional>
+
+class ItemWidget;
+struct ItemDef;
+
+// ItemPool
+// 按 item 句柄分桶的 ItemWidget 对象池：
+// - acquire：桶里有就复用（reset 帧和状态），没有才 new
+// - release：隐藏并放回桶里，代替 deleteLater；桶满或全池满（maxPooled）才真正释放
+// - prewarm：提前建好几个隐藏实例，下次生成不用现场构造；同样受两个上限约束
+// 大目录下不要对每个物品 prewarm：池的大小只跟实际用过的物品走。
+// 新建实例时调用一次 onCreate（连 dropped / dragStarted 等信号），复用时不再连。
+class ItemPool
+{
+public:
+    using CreateHook = std::function<void(ItemWidget *)>;
+
+    void setCreateHook(CreateHook fn) { onCreate = std::move(fn); }
+
+    ItemWidget *acquire(const ItemDef *def, QWidget *parent);
+    void release(ItemWidget *item);
+    void prewarm(const ItemDef *def, QWidget *parent, int count);
+
+    qint64 hits() const { return hitCount; }
+    qint64 misses() const { return missCount; }
+    int pooled() const { return pooledCount; }
+    QString report() const;
+
+    static constexpr int maxPerItem = 16;
+    static constexpr int maxPooled = 64; // 所有桶合计
+
+private:
+    CreateHook onCreate;
+    QVector<QVector<ItemWidget *>> buckets; // 下标 = item 句柄
+    qint64 hitCount = 0;
+    qint64 missCount = 0;
+    int pooledCount = 0;
+
+    ItemWidget *create(const ItemDef *def, QWidget *parent);
+};
@@ -1,42 +1,193 @@
 #include "itemwidget.h"
+#include "interner.h"
+#include "metrics.h"
+#include "powerpolicy.h"
+#include "lodgovernor.h"
 
-ItemWidget::ItemWidget(const QString &itemId,
-                       const QVector<QPixmap> &f,
-                       int intervalMs,
+#include <QPainter>
+#include <algorithm>
+
+ItemWidget::ItemWidget(int itemHandle,
+                       const ClipHandle &c,
+                       int frameIntervalMs,
                        QWidget *parent)
-    : QLabel(parent), id(itemId), frames(f)
+    : QLabel(parent)
 {
     setAttribute(Qt::WA_TranslucentBackground);
     setScaledContents(false);
 
+    static Metrics::Value &framesShown = Metrics::instance().counter(
+        "expldy_frames_shown_total", "Animation frames shown", R"(kind="item")");
+
+    // 只连一次：reset() 复用时不再重复 connect
+    connect(&anim, &QTimer::timeout, this, [this]()
+            {
+        if (frames.isEmpty())
+            return;
+        QElapsedTimer cost;
+        cost.start();
+        framesShown.fetch_add(1, std::memory_order_relaxed);
+        const int step = animStep();
+        idx = (idx + step) % frames.size();
+        if (proxy)
+            emit frameChanged(this); // 由角色合成绘制
+        else
+            refreshFrame();
+        if (frameDuration(frames, idx, intervalMs) * lod != animTickMs)
+            driveAnim();
+        LodGovernor::instance().addWork(cost.nsecsElapsed() / 1000); });
+
+    // 池里待复用（隐藏）的实例不跟着恢复
+    connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, this, [this]()
+            {
+        if (!isHidden() && frames.size() > 1)
+            driveAnim(); });
+
+    LodGovernor::instance().track(this);
+    reset(itemHandle, c, frameIntervalMs);
+}
+
+void ItemWidget::reset(int itemHandle, const ClipHandle &c, int frameIntervalMs)
+{
+    park();
+
+    handle = itemHandle;
+    clip = c;
+    frames = clip ? clip->frames : SpriteFrames();
+    idx = 0;
+    if (clip)
+        resize(clip->canvas);
+
+    pressed = false;
+    dragging = false;
+    proxy = false;
+    sampleCount = 0;
+    throwVelocity = QPointF();
+    equipped = false;
+    spawned = false;
+    hpValue = 0;
+
+    lastDrawn = rect();
     refreshFrame();
 
+    intervalMs = frameIntervalMs;
+    lod = 1; // 下一次 LOD 评估再按新位置定
     if (frames.size() > 1)
+        driveAnim();
+}
+
+int ItemWidget::animStep() const
+{
+    // 短 clip 不整圈跳回原帧（那样看起来像停住了）
+    return std::clamp(lod, 1, std::max(1, int(frames.size()) - 1));
+}
+
+void ItemWidget::driveAnim()
+{
+    animTickMs = frameDuration(frames, idx, intervalMs) * lod;
+    PowerPolicy::instance().drive(anim, animTickMs);
+}
+
+void ItemWidget::setLodDivisor(int n)
+{
+    n = pressed ? 1 : std::max(1, n);
+    if (n == lod)
+        return;
+    lod = n;
+    if (!isHidden() && frames.size() > 1)
+        driveAnim();
+}
+
+void ItemWidget::park()
+{
+    anim.stop();
+    if (grabbing)
     {
-        anim.start(intervalMs);
-        connect(&anim, &QTimer::timeout, this, [this]()
-                {
-            idx = (idx + 1) % frames.size();
-            refreshFrame(); });
+        releaseMouse();
+        grabbing = false;
     }
+    pressed = false;
+    dragging = false;
 }
 
-void ItemWidget::refreshFrame()
+void ItemWidget::setProxy(bool on)
+{
+    if (proxy == on)
+        return;
+    proxy = on;
+    update();
+    emit frameChanged(this);
+}
+
+QString ItemWidget::itemId() const
+{
+    return itemIdTable().name(handle);
+}
+
+QRect ItemWidget::opaqueRect() const
 {
     if (frames.isEmpty())
+        return rect();
+    return frames[idx].rect();
+}
+
+void ItemWidget::refreshFrame()
+{
+    // 只重画前后两帧的包围盒，透明边不参与填充
+    update(lastDrawn.united(opaqueRect()));
+    lastDrawn = opaqueRect();
+}
+
+void ItemWidget::paintEvent(QPaintEvent *)
+{
+    if (frames.isEmpty() || proxy)
         return;
-    setPixmap(frames[idx]);
-    resize(frames[idx].size());
+    QPainter p(this);
+    const SpriteFrame &f = frames[idx];
+    p.drawPixmap(f.offset, f.pixmap);
 }
 
 void ItemWidget::mousePressEvent(QMouseEvent *e)
 {
+    // 透明边不算命中：交给下面的控件（装备时就是角色本身）
+    if (!opaqueRect().contains(e->position().toPoint()))
+    {
+        e->ignore();
+        return;
+    }
+
     if (e->button() == Qt::LeftButton)
     {
+        // 已装备的物品是角色的子控件（会被角色区域裁剪）：
+        // 按下时先摘回顶层窗口、位置不变，才能拖出角色范围
+        QWidget *top = window();
+        if (parentWidget() && parentWidget() != top)
+        {
+            const QPoint p = mapTo(top, QPoint(0, 0));
+            setParent(top);
+            move(p);
+            show();
+            grabMouse();
+            grabbing = true;
+            setProxy(false); // 摘下后自己画，角色回到不带这件装备的帧
+        }
+
         pressed = true;
+        dragging = false;
+        if (lod != 1)
+        {
+            lod = 1; // 拿在手里的物品立即回到原速，不等下一次 LOD 评估
+            if (frames.size() > 1)
+                driveAnim();
+        }
         pressGlobal = e->globalPosition().toPoint();
         startPos = pos();
         raise();
+
+        sampleCount = 0;
+        throwVelocity = QPointF();
+        moveClock.start();
+        recordSample(e->globalPosition());
     }
     QLabel::mousePressEvent(e);
 }
@@ -50,17 +201,63 @@ void ItemWidget::mouseMoveEvent(QMouseEvent *e)
 
     QPoint now = e->globalPosition().toPoint();
     QPoint delta = now - pressGlobal;
-    if (delta.manhattanLength() < dragThreshold)
-        return;
+    if (!dragging)
+    {
+        if (delta.manhattanLength() < dragThreshold)
+            return;
+        dragging = true;
+        emit dragStarted(this);
+    }
 
     move(startPos + delta);
+    recordSample(e->globalPosition());
+}
+
+void ItemWidget::recordSample(const QPointF &globalPos)
+{
+    samples[size_t(sampleHead)] = {moveClock.elapsed(), globalPos};
+    sampleHead = (sampleHead + 1) % int(samples.size());
+    sampleCount = std::min(sampleCount + 1, int(samples.size()));
+}
+
+QPointF ItemWidget::computeVelocity() const
+{
+    if (sampleCount < 2)
+        return QPointF();
+
+    const int n = int(samples.size());
+    const MoveSample &last = samples[size_t((sampleHead - 1 + n) % n)];
+    const qint64 now = moveClock.elapsed();
+    if (now - last.ms > kVelocityWindowMs / 2)
+        return QPointF(); // 停住之后才松手：不是扔
+
+    // 往回找窗口内最早的一次
+    const MoveSample *first = &last;
+    for (int k = 2; k <= sampleCount; ++k)
+    {
+        const MoveSample &s = samples[size_t((sampleHead - k + n) % n)];
+        if (last.ms - s.ms > kVelocityWindowMs)
+            break;
+        first = &s;
+    }
+    const qint64 dt = last.ms - first->ms;
+    if (dt <= 0)
+        return QPointF();
+    return (last.pos - first->pos) * (1000.0 / double(dt));
 }
 
 void ItemWidget::mouseReleaseEvent(QMouseEvent *e)
 {
     if (e->button() == Qt::LeftButton)
     {
+        throwVelocity = dragging ? computeVelocity() : QPointF();
         pressed = false;
+        dragging = false;
+        if (grabbing)
+        {
+            releaseMouse();
+            grabbing = false;
+        }
         emit dropped(this);
     }
     QLabel::mouseReleaseEvent(e);
@@ -5,6 +5,12 @@
 #include <QTimer>
 #include <QVector>
 #include <QPixmap>
+#include <QPaintEvent>
+#include <QElapsedTimer>
+#include <QPointF>
+#include <array>
+
+#include "assetstore.h"
 
 class ItemWidget : public QLabel
 {
@@ -16,33 +22,91 @@ public:
     // 用于怪物等“生成到场景里”的物体标记（阶段1/2：最小闭环）
     bool isSpawned() const { return spawned; }
     void setSpawned(bool v) { spawned = v; }
-    explicit ItemWidget(const QString &itemId,
-                        const QVector<QPixmap> &frames,
-                        int intervalMs,
+
+    // 实例血量（怪物用，初值来自 ItemStats::hp）
+    int hp() const { return hpValue; }
+    void setHp(int v) { hpValue = v; }
+    explicit ItemWidget(int itemHandle,
+                        const ClipHandle &clip,
+                        int frameIntervalMs,
                         QWidget *parent = nullptr);
 
-    QString itemId() const { return id; }
+    // itemIdTable() 句柄；ItemDB::get(int) 直接按下标取定义
+    int itemHandle() const { return handle; }
+    QString itemId() const;
+
+    // 当前帧不透明像素的范围（本地坐标），用于命中/重叠判定
+    QRect opaqueRect() const;
+
+    // 对象池复用：换成另一个物品的帧，状态（装备/生成/血量/拖动）全部清零
+    void reset(int itemHandle, const ClipHandle &clip, int frameIntervalMs);
+    // 回收进池：停动画、松开鼠标抓取
+    void park();
+
+    // 代理模式：装备由角色作为额外一层画出（LayeredFrame），本控件不再绘制，只负责点击命中/摘下。
+    // 动画照常前进，每帧发 frameChanged 让角色重新合成；被拖离角色时自动退出代理模式
+    void setProxy(bool on);
+    bool isProxy() const { return proxy; }
+    const SpriteFrame *currentFrame() const { return frames.isEmpty() ? nullptr : &frames[idx]; }
+
+    // 正按着（包括还没越过拖动阈值时）：物理模拟不碰它
+    bool isHeld() const { return pressed; }
+    // 松手那一刻的拖动速度（像素/秒）：取最近 kVelocityWindowMs 内的移动；松手前停住则为 0
+    QPointF releaseVelocity() const { return throwVelocity; }
+
+    // LodGovernor 定的帧率除数：n > 1 时每 tick 跳 n 帧、间隔乘 n。按住期间忽略（原速）
+    void setLodDivisor(int n);
+    int lodDivisor() const { return lod; }
 
 signals:
+    void dragStarted(ItemWidget *item); // 越过拖动阈值的那一刻（用于预取音效等）
     void dropped(ItemWidget *item);
+    void frameChanged(ItemWidget *item); // 代理模式下换帧，或进出代理模式
 
 protected:
+    void paintEvent(QPaintEvent *e) override;
     void mousePressEvent(QMouseEvent *e) override;
     void mouseMoveEvent(QMouseEvent *e) override;
     void mouseReleaseEvent(QMouseEvent *e) override;
 
 private:
-    QString id;
-    QVector<QPixmap> frames;
+    int handle = -1;
+    ClipHandle clip; // 控件大小 = clip->canvas，帧按 offset 画在里面
+    SpriteFrames frames;
     int idx = 0;
+    QRect lastDrawn;
     QTimer anim;
+    int intervalMs = 120; // 默认帧间隔（manifest），帧自带时长时以帧为准
+    int animTickMs = 120; // anim 当前按哪个间隔（已乘 LOD 除数）运行；实际间隔再由 PowerPolicy 档位决定
+    int lod = 1;
+    int animStep() const; // 每 tick 前进的帧数
+    void driveAnim();
 
     bool pressed = false;
+    bool dragging = false;
+    bool grabbing = false; // 从角色身上摘下来后显式抓鼠标，直到松手
+    bool proxy = false;
     QPoint pressGlobal;
     QPoint startPos;
     int dragThreshold = 4;
 
+    // 拖动轨迹：最近几次 mouseMove 的 (时刻, 全局坐标)，环形覆盖
+    struct MoveSample
+    {
+        qint64 ms = 0;
+        QPointF pos;
+    };
+    std::array<MoveSample, 8> samples;
+    int sampleCount = 0;
+    int sampleHead = 0; // 下一次写入的位置
+    QElapsedTimer moveClock;
+    QPointF throwVelocity;
+    static constexpr int kVelocityWindowMs = 80;
+    void recordSample(const QPointF &globalPos);
+    QPointF computeVelocity() const;
+
     void refreshFrame();
     bool equipped = false;
     bool spawned = false;
+    int hpValue = 0;
 };
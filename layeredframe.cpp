@@ -0,0 +1,20 @@
+#include "layeredframe.h"
+
+#include <QPainter>
+
+QRect LayeredFrame::rect() const
+{
+    QRect u = base.rect();
+    for (const Layer *l : {&shield, &weapon})
+        if (l->present)
+            u = u.united(l->rect());
+    return u;
+}
+
+void LayeredFrame::draw(QPainter &p) const
+{
+    p.drawPixmap(base.offset, base.pixmap);
+    for (const Layer *l : {&shield, &weapon})
+        if (l->present)
+            p.drawPixmap(l->pos + l->frame.offset, l->frame.pixmap);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <QPoint>
+#include <QRect>
+
+#include "assetstore.h"
+
+class QPainter;
+
+// LayeredFrame
+// 角色当前画面 = 角色帧 + 挂在身上的装备帧，在角色的一次 paintEvent 里逐层 blit。
+// - 每层都是帧池里现成的 pixmap（隐式共享），不做离屏合成，也不需要按帧组合缓存
+// - 角色/装备换帧、交叉淡化中间帧都只是换掉其中一层，每个 tick 没有 QPainter 合成
+class LayeredFrame
+{
+public:
+    struct Layer
+    {
+        SpriteFrame frame;
+        QPoint pos;           // 装备控件左上角（角色本地坐标），帧画在 pos + frame.offset
+        bool present = false; // false 表示这一层不存在
+
+        QRect rect() const { return present ? frame.rect().translated(pos) : QRect(); }
+    };
+
+    // 从下到上：base、shield、weapon
+    SpriteFrame base;
+    Layer shield;
+    Layer weapon;
+
+    QRect rect() const; // 三层包围盒的并集（角色本地坐标）
+    void draw(QPainter &p) const;
+};
@@ -0,0 +1,26 @@
+#include "localserver.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace
+{
+    constexpr int kProbeTimeoutMs = 200;
+}
+
+bool listenLocalServer(QLocalServer &server, const QString &name)
+{
+    if (server.listen(name))
+        return true;
+
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(kProbeTimeoutMs))
+    {
+        probe.disconnectFromServer();
+        return false;
+    }
+
+    QLocalServer::removeServer(name);
+    return server.listen(name);
+}
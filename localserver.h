@@ -0,0 +1,9 @@
+#pragma once
+#include <QString>
+
+class QLocalServer;
+
+// 在 name 上监听。失败时先试着连一下：
+// - 连得上：另一个实例正在用这个名字，直接返回 false（不抢它的 socket）
+// - 连不上：上次崩溃留下的 socket 文件，清掉再试一次
+bool listenLocalServer(QLocalServer &server, const QString &name);
@@ -0,0 +1,160 @@
+#include "lodgovernor.h"
+#include "itemwidget.h"
+#include "metrics.h"
+#include "powerpolicy.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <algorithm>
+
+namespace
+{
+    constexpr double kFrameMs = 16.0;  // 负载按每 16 ms 折算
+    constexpr int kSmallArea = 40 * 40; // 不透明面积小于它的物品按“远”处理
+}
+
+LodGovernor &LodGovernor::instance()
+{
+    static QPointer<LodGovernor> governor;
+    if (!governor)
+        governor = new LodGovernor(QCoreApplication::instance()); // 随应用退出释放
+    return *governor;
+}
+
+LodGovernor::LodGovernor(QObject *parent)
+    : QObject(parent)
+{
+    enabled = qEnvironmentVariable("EXPLDY_LOD").compare("off", Qt::CaseInsensitive) != 0;
+
+    bool ok = false;
+    const double envBudget = qEnvironmentVariable("EXPLDY_FRAME_BUDGET_MS").toDouble(&ok);
+    if (ok && envBudget > 0)
+        budget = envBudget;
+
+    Metrics &m = Metrics::instance();
+    const QPointer<LodGovernor> self(this);
+    m.gaugeFn("expldy_lod_level", "Animation level of detail (0 = full rate)", QString(),
+              [self]()
+              { return self ? double(self->current) : 0.0; });
+    m.gaugeFn("expldy_lod_slowed_items", "Items animating below full rate", QString(),
+              [self]()
+              { return self ? double(self->slowed) : 0.0; });
+    m.gaugeFn("expldy_frame_load_seconds", "GUI work per 16 ms frame over the last governor window", QString(),
+              [self]()
+              { return self ? self->lastLoadMs / 1000.0 : 0.0; });
+
+    if (!enabled)
+        return;
+
+    connect(&tick, &QTimer::timeout, this, [this]()
+            { evaluate(); });
+    // 暂停期间没有工作，不要把整段暂停算进下一个窗口
+    connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, this, [this]()
+            {
+        workUs = 0;
+        window.restart();
+        PowerPolicy::instance().drive(tick, kWindowMs); });
+
+    window.start();
+    PowerPolicy::instance().drive(tick, kWindowMs);
+}
+
+void LodGovernor::track(ItemWidget *item)
+{
+    items.push_back(item);
+}
+
+void LodGovernor::evaluate()
+{
+    const qint64 wallUs = window.nsecsElapsed() / 1000;
+    window.restart();
+    if (wallUs <= 0)
+        return;
+
+    lastLoadMs = double(workUs) / 1000.0 * (kFrameMs * 1000.0 / double(wallUs));
+    workUs = 0;
+
+    if (lastLoadMs > budget)
+    {
+        calm = 0;
+        if (++hot >= kRaiseAfter && current < kMaxLevel)
+        {
+            hot = 0;
+            setLevel(current + 1);
+        }
+    }
+    else if (lastLoadMs < budget * kRestoreRatio)
+    {
+        hot = 0;
+        if (++calm >= kRestoreAfter && current > 0)
+        {
+            calm = 0;
+            setLevel(current - 1);
+        }
+    }
+    else
+    {
+        hot = 0;
+        calm = 0;
+    }
+
+    apply();
+}
+
+void LodGovernor::setLevel(int next)
+{
+    qDebug() << "lod:" << current << "->" << next << "load" << QString::number(lastLoadMs, 'f', 2)
+             << "ms/frame budget" << budget << "ms";
+    current = next;
+}
+
+void LodGovernor::apply()
+{
+    items.removeAll(QPointer<ItemWidget>());
+
+    QPoint center;
+    int nearRadius = 0;
+    if (focus)
+    {
+        center = focus->mapTo(focus->window(), focus->rect().center());
+        nearRadius = int(std::max(focus->width(), focus->height()) * 1.5);
+    }
+
+    int count = 0;
+    for (const auto &item : std::as_const(items))
+    {
+        if (item->isHidden()) // 池里待复用
+            continue;
+        const int d = current == 0 ? 1 : divisorFor(item, center, nearRadius);
+        item->setLodDivisor(d);
+        if (d > 1)
+            ++count;
+    }
+
+    if (count != slowed && current > 0)
+        qDebug() << "lod: level" << current << "slowed items" << count << "of" << items.size();
+    slowed = count;
+}
+
+int LodGovernor::divisorFor(ItemWidget *item, const QPoint &focusCenter, int nearRadius) const
+{
+    // 装备挂在角色下面（合成进角色帧），和正被按住的物品一样保持原速
+    if (item->isHeld() || item->isEquipped() || (focus && item->parentWidget() == focus))
+        return 1;
+
+    bool far = !focus || item->window() != focus->window();
+    if (!far)
+    {
+        const QPoint c = item->mapTo(item->window(), item->opaqueRect().center());
+        const QPoint d = c - focusCenter;
+        far = qint64(d.x()) * d.x() + qint64(d.y()) * d.y() > qint64(nearRadius) * nearRadius;
+    }
+    const QRect r = item->opaqueRect();
+    if (r.width() * r.height() < kSmallArea)
+        far = true;
+
+    // 远/小：1 档 x2，2 档 x4，3 档 x8；近处：2 档 x2，3 档 x4
+    if (far)
+        return 1 << current;
+    return current >= 2 ? 1 << (current - 1) : 1;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QWidget>
+
+class ItemWidget;
+
+// LodGovernor
+// 动画细节档位：物品/怪物一多，绘制和动画 tick 的耗时超过帧预算时，先给次要的精灵降帧率。
+// - 负载 = 每 16 ms 里花在绘制（顶层窗口 UpdateRequest）、物品动画 tick、物理上的平均时间，
+//   由各处 addWork() 上报，每 kWindowMs 评估一次
+// - 连续 kRaiseAfter 个窗口超预算升一档（最多 kMaxLevel），连续 kRestoreAfter 个窗口低于预算的
+//   kRestoreRatio 降一档，直到恢复原速
+// - 降帧只作用于散落的 ItemWidget 和怪物：离角色远或很小的先降（1 档起），角色附近的 2 档起才降；
+//   角色本身（WifeLabel）、装备、正被按住/拖动的物品始终原速
+// - 降帧 = 每 tick 跳 n 帧、间隔乘 n：播放速度基本不变，只是画得少（帧数不到 n+1 的短 clip 会变慢）
+// 档位变化打一行日志（lod: ...），并导出 expldy_lod_level / expldy_lod_slowed_items / expldy_frame_load_seconds。
+// 环境变量 EXPLDY_FRAME_BUDGET_MS 设预算（默认 8），EXPLDY_LOD=off 关闭（始终原速）。
+// 只在 GUI 线程使用。
+class LodGovernor : public QObject
+{
+public:
+    static LodGovernor &instance();
+
+    // 角色：距离按它的中心算，它自己不降帧
+    void setFocusWidget(QWidget *w) { focus = w; }
+
+    // ItemWidget 构造时登记，析构后自动剔除
+    void track(ItemWidget *item);
+
+    // 上报一段 GUI 线程工作耗时（微秒）
+    void addWork(qint64 us) { workUs += us; }
+
+    int level() const { return current; }
+    double budgetMs() const { return budget; }
+
+    static constexpr int kMaxLevel = 3;
+    static constexpr int kWindowMs = 500;
+    static constexpr int kRaiseAfter = 2;
+    static constexpr int kRestoreAfter = 4;
+    static constexpr double kRestoreRatio = 0.6;
+
+private:
+    explicit LodGovernor(QObject *parent);
+
+    bool enabled = true;
+    double budget = 8.0; // 毫秒 / 16 ms 帧
+    int current = 0;
+    int hot = 0;  // 连续超预算的窗口数
+    int calm = 0; // 连续低负载的窗口数
+
+    qint64 workUs = 0;
+    double lastLoadMs = 0.0;
+    int slowed = 0;
+
+    QPointer<QWidget> focus;
+    QVector<QPointer<ItemWidget>> items;
+
+    QTimer tick;
+    QElapsedTimer window;
+
+    void evaluate();
+    void setLevel(int next);
+    void apply(); // 按当前档位给每个物品定帧率除数（物品会移动，每个窗口重排一次）
+    int divisorFor(ItemWidget *item, const QPoint &focusCenter, int nearRadius) const;
+};
@@ -1,18 +1,62 @@
 #include <QApplication>
 #include <QWidget>
+#include <QElapsedTimer>
+#include <QEvent>
 #include "wifelabel.h"
+#include "controlserver.h"
+#include "metrics.h"
+#include "powerpolicy.h"
+#include "lodgovernor.h"
+
+// 顶层窗口：每次 UpdateRequest（整窗合成 + 绘制）计时，
+// 和 Qt Quick 前端的 expldy_frame_cost_seconds_total{frontend="quick"} 对比；同一份耗时也报给 LodGovernor
+class PetWindow : public QWidget
+{
+public:
+    PetWindow()
+        : frameCost(Metrics::instance().counterSeconds("expldy_frame_cost_seconds_total",
+                                                       "Time spent producing frames (sync + render for Qt Quick, paint for widgets)",
+                                                       R"(frontend="widgets")")),
+          framesRendered(Metrics::instance().counter("expldy_frames_rendered_total", "Frames produced by the frontend",
+                                                     R"(frontend="widgets")"))
+    {
+    }
+
+protected:
+    bool event(QEvent *e) override
+    {
+        if (e->type() != QEvent::UpdateRequest)
+            return QWidget::event(e);
+
+        QElapsedTimer t;
+        t.start();
+        const bool handled = QWidget::event(e);
+        const qint64 us = t.nsecsElapsed() / 1000;
+        frameCost.fetch_add(us, std::memory_order_relaxed);
+        LodGovernor::instance().addWork(us); // 绘制耗时也算进动画细节档位的负载
+        framesRendered.fetch_add(1, std::memory_order_relaxed);
+        return handled;
+    }
+
+private:
+    Metrics::Value &frameCost;
+    Metrics::Value &framesRendered;
+};
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
-    QWidget window;
+    // 指标导出（EXPLDY_METRICS_FILE / EXPLDY_METRICS_SOCKET）
+    Metrics::instance().startExport();
+
+    PetWindow window;
     window.setWindowTitle("Expldy");
     window.resize(800, 600);
 
     auto *wife = new WifeLabel(&window);
     wife->setTargetSize(QSize(200, 200));
-    wife->loadFromAssets();
+    wife->loadFromAssets(); // 立即返回：第一帧已就绪，其余素材 exec() 后逐步加载
     wife->playIdle();
 
     // 初始居中（窗口内拖动）
@@ -21,5 +65,13 @@ int main(int argc, char *argv[])
         (window.height() - wife->height()) / 2);
 
     window.show();
+
+    // 最小化/遮挡/空闲/电池时降速或暂停动画
+    PowerPolicy::instance().watch(window.windowHandle());
+
+    // 脚本控制口（EXPLDY_CONTROL=off 关闭）
+    ControlServer control(wife);
+    control.listen(ControlServer::defaultName());
+
     return app.exec();
 }
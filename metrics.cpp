@@ -0,0 +1,201 @@
+#include "metrics.h"
+#include "localserver.h"
+
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSaveFile>
+#include <QSet>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+
+namespace
+{
+// 静态初始化阶段就开始计时，比 main() 里任何代码都早
+const QElapsedTimer processClock = []()
+{
+    QElapsedTimer t;
+    t.start();
+    return t;
+}();
+}
+
+qint64 Metrics::uptimeUs()
+{
+    return processClock.nsecsElapsed() / 1000;
+}
+
+Metrics &Metrics::instance()
+{
+    static Metrics m;
+    return m;
+}
+
+Metrics::Series &Metrics::findOrAdd(const QString &name, const QString &help, const QString &labels, Kind kind)
+{
+    QMutexLocker lock(&mutex);
+    for (auto &s : series)
+        if (s.name == name && s.labels == labels)
+            return s;
+
+    series.emplace_back();
+    Series &s = series.back();
+    s.name = name;
+    s.help = help;
+    s.labels = labels;
+    s.kind = kind;
+    return s;
+}
+
+Metrics::Value &Metrics::counter(const QString &name, const QString &help, const QString &labels)
+{
+    return findOrAdd(name, help, labels, Kind::Counter).value;
+}
+
+Metrics::Value &Metrics::gauge(const QString &name, const QString &help, const QString &labels)
+{
+    return findOrAdd(name, help, labels, Kind::Gauge).value;
+}
+
+Metrics::Value &Metrics::gaugeSeconds(const QString &name, const QString &help, const QString &labels)
+{
+    Series &s = findOrAdd(name, help, labels, Kind::Gauge);
+    s.seconds = true;
+    return s.value;
+}
+
+Metrics::Value &Metrics::counterSeconds(const QString &name, const QString &help, const QString &labels)
+{
+    Series &s = findOrAdd(name, help, labels, Kind::Counter);
+    s.seconds = true;
+    return s.value;
+}
+
+void Metrics::gaugeFn(const QString &name, const QString &help, const QString &labels, std::function<double()> fn)
+{
+    Series &s = findOrAdd(name, help, labels, Kind::Gauge);
+    QMutexLocker lock(&mutex);
+    s.fn = std::move(fn);
+}
+
+QByteArray Metrics::render() const
+{
+    // 持锁只拷一份快照；回调（可能遍历控件树）在锁外求值，回调里再注册指标也不会死锁
+    struct Row
+    {
+        QString name;
+        QString help;
+        QString labels;
+        Kind kind;
+        bool seconds;
+        qint64 value;
+        std::function<double()> fn;
+    };
+    std::vector<Row> rows;
+    {
+        QMutexLocker lock(&mutex);
+        rows.reserve(series.size());
+        for (const auto &s : series)
+            rows.push_back({s.name, s.help, s.labels, s.kind, s.seconds, s.value.load(std::memory_order_relaxed), s.fn});
+    }
+
+    QByteArray out;
+    QSet<QString> done;
+    for (const auto &head : rows)
+    {
+        if (done.contains(head.name))
+            continue;
+        done.insert(head.name);
+
+        // 同名不同 labels 的序列放在同一个 HELP/TYPE 下
+        out += "# HELP " + head.name.toUtf8() + ' ' + head.help.toUtf8() + '\n';
+        out += "# TYPE " + head.name.toUtf8() + (head.kind == Kind::Counter ? " counter\n" : " gauge\n");
+        for (const auto &s : rows)
+        {
+            if (s.name != head.name)
+                continue;
+
+            out += s.name.toUtf8();
+            if (!s.labels.isEmpty())
+                out += '{' + s.labels.toUtf8() + '}';
+            out += ' ';
+            if (s.fn)
+                out += QByteArray::number(s.fn(), 'g', 12);
+            else if (s.seconds)
+                out += QByteArray::number(double(s.value) / 1e6, 'g', 12);
+            else
+                out += QByteArray::number(s.value);
+            out += '\n';
+        }
+    }
+    return out;
+}
+
+void Metrics::writeFile()
+{
+    QSaveFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly))
+        return;
+    f.write(render());
+    f.commit(); // 原子替换，抓取方不会读到写了一半的文件
+}
+
+void Metrics::startExport()
+{
+    if (exporting || !qApp)
+        return;
+    exporting = true;
+
+    // 事件循环延迟探测：到点晚了多少就是主线程被占用了多久
+    lagLast = &gaugeSeconds("expldy_event_loop_lag_seconds", "Lateness of the last event-loop probe timer");
+    lagTotal = &counterSeconds("expldy_event_loop_lag_seconds_total", "Accumulated event-loop probe lateness");
+    auto *probe = new QTimer(qApp);
+    probe->setTimerType(Qt::PreciseTimer);
+    lagClock.start();
+    QObject::connect(probe, &QTimer::timeout, qApp, [this]()
+                     {
+        const qint64 us = lagClock.nsecsElapsed() / 1000;
+        lagClock.restart();
+        const qint64 lag = std::max<qint64>(0, us - qint64(lagProbeMs) * 1000);
+        lagLast->store(lag, std::memory_order_relaxed);
+        lagTotal->fetch_add(lag, std::memory_order_relaxed); });
+    probe->start(lagProbeMs);
+
+    filePath = qEnvironmentVariable("EXPLDY_METRICS_FILE");
+    if (!filePath.isEmpty())
+    {
+        bool ok = false;
+        int periodMs = qEnvironmentVariableIntValue("EXPLDY_METRICS_INTERVAL_MS", &ok);
+        if (!ok || periodMs < 1000)
+            periodMs = 15000;
+
+        auto *timer = new QTimer(qApp);
+        QObject::connect(timer, &QTimer::timeout, qApp, [this]()
+                         { writeFile(); });
+        timer->start(periodMs);
+        writeFile();
+        qDebug() << "metrics: writing" << filePath << "every" << periodMs << "ms";
+    }
+
+    const QString socketName = qEnvironmentVariable("EXPLDY_METRICS_SOCKET");
+    if (!socketName.isEmpty())
+    {
+        auto *server = new QLocalServer(qApp);
+        server->setSocketOptions(QLocalServer::UserAccessOption);
+        if (!listenLocalServer(*server, socketName))
+        {
+            qWarning() << "metrics: cannot listen on" << socketName << server->errorString();
+            server->deleteLater();
+            return;
+        }
+        QObject::connect(server, &QLocalServer::newConnection, qApp, [this, server]()
+                         {
+            while (QLocalSocket *sock = server->nextPendingConnection()) {
+                QObject::connect(sock, &QLocalSocket::disconnected, sock, &QObject::deleteLater);
+                sock->write(render());
+                sock->disconnectFromServer(); // 写完自动断开（缓冲区刷完才真正关闭）
+            } });
+        qDebug() << "metrics: serving on" << server->fullServerName();
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+// Metrics
+// 进程级计数器/仪表，按 Prometheus 文本格式（exposition format 0.0.4）导出，给运维抓取。
+// - counter / gauge 注册一次，返回的引用在进程内一直有效：热路径只是一次原子加，不加锁不查表
+// - gaugeFn：抓取时才求值的仪表（实体数、常驻字节等），不用在每个改动点维护
+// - 导出：EXPLDY_METRICS_FILE 指定文件则定期原子重写（node_exporter textfile 收集器可直接读）；
+//         EXPLDY_METRICS_SOCKET 指定本地 socket 名则每个连接写一份快照后断开
+// 事件循环延迟：固定间隔的探测计时器实际触发时间与预期之差（最近一次 + 累计）。
+class Metrics
+{
+public:
+    static Metrics &instance();
+
+    using Value = std::atomic<qint64>;
+
+    // labels 形如 R"(channel="voice")"；同名同 labels 重复注册返回同一个
+    Value &counter(const QString &name, const QString &help, const QString &labels = QString());
+    Value &gauge(const QString &name, const QString &help, const QString &labels = QString());
+    void gaugeFn(const QString &name, const QString &help, const QString &labels, std::function<double()> fn);
+
+    // 以秒为单位导出，内部按微秒存
+    Value &gaugeSeconds(const QString &name, const QString &help, const QString &labels = QString());
+    Value &counterSeconds(const QString &name, const QString &help, const QString &labels = QString());
+
+    QByteArray render() const;
+
+    // 进程启动（静态初始化）以来的微秒数，启动耗时类指标用
+    static qint64 uptimeUs();
+
+    // 按环境变量开启文件/socket 导出和事件循环延迟探测（在 QApplication 创建后调用一次）
+    void startExport();
+
+private:
+    Metrics() = default;
+
+    enum class Kind
+    {
+        Counter,
+        Gauge
+    };
+
+    struct Series
+    {
+        QString name;
+        QString help;
+        QString labels;
+        Kind kind = Kind::Counter;
+        bool seconds = false; // value 为微秒，导出时换算成秒
+        Value value{0};
+        std::function<double()> fn; // 非空则抓取时求值
+    };
+
+    mutable QMutex mutex;          // 只保护注册和渲染；计数本身是原子操作
+    std::deque<Series> series;     // deque：追加不移动已有元素，返回的引用一直有效
+
+    Series &findOrAdd(const QString &name, const QString &help, const QString &labels, Kind kind);
+
+    // 导出用的计时器/本地 server 都挂在 qApp 上，随应用退出释放（Metrics 本身是静态对象）
+    QString filePath;
+    bool exporting = false;
+
+    QElapsedTimer lagClock;
+    Value *lagLast = nullptr;
+    Value *lagTotal = nullptr;
+    static constexpr int lagProbeMs = 100;
+
+    void writeFile();
+};
@@ -0,0 +1,227 @@
+#include "particles.h"
+#include "metrics.h"
+#include "powerpolicy.h"
+
+#include <QEvent>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float kPi = 3.14159265f;
+    constexpr float kSparkTailSec = 0.03f; // 火花尾巴 = 最近 30 ms 的轨迹
+    constexpr float kSparkTailMax = 12.f;  // 像素；bounds() 按它留余量
+}
+
+ParticleLayer::ParticleLayer(QWidget *window)
+    : QWidget(window)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setGeometry(window->rect());
+    window->installEventFilter(this);
+
+    for (auto *v : {&px, &py, &vx, &vy, &age, &life, &size, &grav})
+        v->resize(kCapacity);
+    color.resize(kCapacity);
+    shape.resize(kCapacity);
+
+    connect(&tick, &QTimer::timeout, this, [this]()
+            {
+        // 计时器被降档/暂停过也不会一步跳太远
+        const float dt = std::min<qint64>(clock.restart(), 50) / 1000.f;
+        step(dt); });
+
+    connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, this, [this]()
+            {
+        if (n > 0)
+        {
+            clock.restart();
+            PowerPolicy::instance().drive(tick, kTickMs);
+        } });
+
+    hide();
+}
+
+void ParticleLayer::burst(const QPointF &pos, const EffectDef &def)
+{
+    static Metrics::Value &emitted = Metrics::instance().counter(
+        "expldy_particles_emitted_total", "Particles emitted");
+    static Metrics::Value &dropped = Metrics::instance().counter(
+        "expldy_particles_dropped_total", "Particles dropped because the pool was full");
+
+    if (def.isNull())
+        return;
+
+    const int want = def.count;
+    const int take = std::min(want, kCapacity - n);
+    emitted.fetch_add(take, std::memory_order_relaxed);
+    if (take < want)
+        dropped.fetch_add(want - take, std::memory_order_relaxed);
+
+    QRandomGenerator *rng = QRandomGenerator::global();
+    const float life0 = std::max(1.f, def.lifeMs) / 1000.f;
+    const float halfSpread = def.spread * kPi / 360.f;
+    for (int k = 0; k < take; ++k)
+    {
+        const int i = n++;
+        // 方向：以正上方为中心的扇形；速度和寿命各带一点随机
+        const float a = -kPi / 2 + float(rng->bounded(2.0) - 1.0) * halfSpread;
+        const float s = def.speed * float(0.4 + 0.6 * rng->bounded(1.0));
+        px[i] = float(pos.x());
+        py[i] = float(pos.y());
+        vx[i] = std::cos(a) * s;
+        vy[i] = std::sin(a) * s;
+        age[i] = 0.f;
+        life[i] = life0 * float(0.75 + 0.5 * rng->bounded(1.0));
+        size[i] = def.size;
+        grav[i] = def.gravity;
+        color[i] = def.color;
+        shape[i] = def.shape;
+    }
+
+    if (take == 0)
+        return;
+
+    // 物品 raise() 过的话会盖住这一层
+    raise();
+    if (isHidden())
+        show();
+    if (!tick.isActive())
+    {
+        clock.restart();
+        PowerPolicy::instance().drive(tick, kTickMs);
+    }
+    const QRect r = bounds();
+    update(dirty.united(r));
+    dirty = r;
+}
+
+void ParticleLayer::step(float dt)
+{
+    // 每个字段一个循环：纯 float 数组上的乘加，没有分支
+    const int m = n;
+    float *x = px.data();
+    float *y = py.data();
+    float *u = vx.data();
+    float *v = vy.data();
+    float *t = age.data();
+    const float *g = grav.data();
+    for (int i = 0; i < m; ++i)
+        v[i] += g[i] * dt;
+    for (int i = 0; i < m; ++i)
+        x[i] += u[i] * dt;
+    for (int i = 0; i < m; ++i)
+        y[i] += v[i] * dt;
+    for (int i = 0; i < m; ++i)
+        t[i] += dt;
+
+    compact();
+
+    const QRect r = bounds();
+    update(dirty.united(r));
+    dirty = r;
+
+    if (n == 0)
+    {
+        tick.stop();
+        hide();
+        dirty = QRect();
+    }
+}
+
+void ParticleLayer::compact()
+{
+    // 过期的用末尾的活粒子填上：顺序无所谓，不移动其余元素
+    for (int i = 0; i < n;)
+    {
+        if (age[i] < life[i])
+        {
+            ++i;
+            continue;
+        }
+        const int last = --n;
+        px[i] = px[last];
+        py[i] = py[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        age[i] = age[last];
+        life[i] = life[last];
+        size[i] = size[last];
+        grav[i] = grav[last];
+        color[i] = color[last];
+        shape[i] = shape[last];
+    }
+}
+
+QRect ParticleLayer::bounds() const
+{
+    if (n == 0)
+        return QRect();
+
+    float x0 = px[0], x1 = px[0], y0 = py[0], y1 = py[0], pad = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        x0 = std::min(x0, px[i]);
+        x1 = std::max(x1, px[i]);
+        y0 = std::min(y0, py[i]);
+        y1 = std::max(y1, py[i]);
+        pad = std::max(pad, size[i]);
+    }
+    pad += kSparkTailMax;
+    return QRect(QPoint(int(std::floor(x0 - pad)), int(std::floor(y0 - pad))),
+                 QPoint(int(std::ceil(x1 + pad)), int(std::ceil(y1 + pad))));
+}
+
+void ParticleLayer::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing, false);
+    p.setPen(Qt::NoPen);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const float k = 1.f - std::clamp(age[i] / life[i], 0.f, 1.f); // 剩余寿命，线性淡出
+        QColor c = QColor::fromRgba(color[i]);
+        c.setAlphaF(c.alphaF() * k);
+
+        switch (shape[i])
+        {
+        case EffectDef::Shape::Square:
+        {
+            const float s = size[i];
+            p.fillRect(QRectF(px[i] - s / 2, py[i] - s / 2, s, s), c);
+            break;
+        }
+        case EffectDef::Shape::Spark:
+        {
+            const float speed = std::hypot(vx[i], vy[i]);
+            const float tail = speed * kSparkTailSec > kSparkTailMax ? kSparkTailMax / speed : kSparkTailSec;
+            // 复用同一支笔：setPen(NoPen) 之后画笔的数据只剩这里一份引用，改颜色/线宽不分离、不分配
+            sparkPen.setColor(c);
+            sparkPen.setWidthF(size[i]);
+            p.setPen(sparkPen);
+            p.drawLine(QPointF(px[i], py[i]), QPointF(px[i] - vx[i] * tail, py[i] - vy[i] * tail));
+            p.setPen(Qt::NoPen);
+            break;
+        }
+        case EffectDef::Shape::Flash:
+        {
+            // 半径从 size 的一半长到 size
+            const float r = size[i] * (1.f - 0.5f * k);
+            p.setBrush(c);
+            p.drawEllipse(QPointF(px[i], py[i]), r, r);
+            break;
+        }
+        }
+    }
+}
+
+bool ParticleLayer::eventFilter(QObject *obj, QEvent *ev)
+{
+    if (obj == parentWidget() && ev->type() == QEvent::Resize)
+        setGeometry(parentWidget()->rect());
+    return QWidget::eventFilter(obj, ev);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointF>
+#include <QPen>
+#include <QRect>
+#include <vector>
+
+#include "effectdef.h"
+
+// ParticleLayer
+// 整个窗口共用的一层粒子：碎屑、火花、受击闪光都在这里，不为每个粒子建控件。
+// - 粒子存成预分配的 struct-of-arrays 池（kCapacity），满了新粒子直接丢弃；稳态不分配内存
+// - 一个 16 ms 计时器推进所有粒子，每个字段一个连续的 float 循环（编译器可以向量化）
+// - 一个 paintEvent 画完全部粒子，只重画粒子包围盒
+// - 没有活粒子时隐藏并停表；计时器按 PowerPolicy 档位运行
+class ParticleLayer : public QWidget
+{
+public:
+    explicit ParticleLayer(QWidget *window); // 铺满 window，不接收鼠标
+
+    // pos 为本层（即窗口）坐标
+    void burst(const QPointF &pos, const EffectDef &def);
+    int alive() const { return n; }
+
+    static constexpr int kCapacity = 2048;
+    static constexpr int kTickMs = 16;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool eventFilter(QObject *obj, QEvent *ev) override; // 跟随窗口尺寸
+
+private:
+    // SoA：下标 [0, n) 是活粒子
+    std::vector<float> px, py, vx, vy, age, life, size, grav;
+    std::vector<QRgb> color;
+    std::vector<EffectDef::Shape> shape;
+    int n = 0;
+
+    QTimer tick;
+    QElapsedTimer clock;
+    QRect dirty; // 上一帧画过的范围
+    QPen sparkPen{Qt::white, 1.0, Qt::SolidLine, Qt::RoundCap}; // 火花共用，绘制时只改颜色和线宽
+
+    void step(float dt);
+    void compact();
+    QRect bounds() const;
+};
@@ -0,0 +1,387 @@
+#include "physics.h"
+#include "itemwidget.h"
+#include "powerpolicy.h"
+#include "lodgovernor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 向下取整的除法：窗口外（负坐标）的格子也连续
+    int cellOf(int v)
+    {
+        return v >= 0 ? v / ItemPhysics::kCell : -((-v + ItemPhysics::kCell - 1) / ItemPhysics::kCell);
+    }
+
+    constexpr float kRestSpeed = 15.f;   // 着地且水平速度低于它：开始计静止时间
+    constexpr float kRestSec = 0.3f;     // 静止这么久就入睡
+    constexpr float kBounceCutoff = 60.f; // 着地反弹低于它直接停住，不做微小抖动
+    constexpr int kMaxSteps = 12;        // 一个 tick 最多追的步数（卡顿后不螺旋追赶）
+}
+
+ItemPhysics::ItemPhysics()
+{
+    QObject::connect(&tick, &QTimer::timeout, &tick, [this]()
+                     { advance(); });
+    QObject::connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, &tick, [this]()
+                     {
+        if (!bodies.isEmpty())
+        {
+            clock.restart();
+            PowerPolicy::instance().drive(tick, kTickMs);
+        } });
+}
+
+void ItemPhysics::throwItem(ItemWidget *item, const QPointF &velocity)
+{
+    if (!item || !item->parentWidget())
+        return;
+
+    forget(item);
+    world = item->parentWidget();
+
+    Body b;
+    b.w = item;
+    b.pos = item->pos();
+    b.vel = velocity;
+    b.box = item->opaqueRect();
+    bodies.push_back(b);
+
+    if (!tick.isActive())
+    {
+        clock.restart();
+        accumulator = 0.f;
+        PowerPolicy::instance().drive(tick, kTickMs);
+    }
+}
+
+void ItemPhysics::settle(ItemWidget *item)
+{
+    if (!item || !item->parentWidget())
+        return;
+
+    forget(item);
+    world = item->parentWidget();
+
+    Body b;
+    b.w = item;
+    b.pos = item->pos();
+    b.box = item->opaqueRect();
+
+    // 脚下两像素的条带：入睡时位置取整过，和支撑面可能差一像素
+    const QRect r(item->pos() + b.box.topLeft(), b.box.size());
+    const QRect below(r.left(), r.bottom() + 1, r.width(), 2);
+    bool supported = below.bottom() >= world->height() - 1;
+    if (!supported && obstacle)
+        supported = obstacle().intersects(below);
+    if (!supported)
+    {
+        gatherSleepers(below, found);
+        supported = !found.isEmpty();
+    }
+
+    if (supported)
+        sleep(b);
+    else
+        throwItem(item, QPointF());
+}
+
+void ItemPhysics::forget(ItemWidget *item)
+{
+    for (int i = 0; i < bodies.size(); ++i)
+    {
+        if (bodies[i].w == item)
+        {
+            bodies[i] = bodies.last();
+            bodies.removeLast();
+            break;
+        }
+    }
+
+    const QRect was = removeSleeper(item);
+    if (!was.isEmpty())
+        wake(was);
+}
+
+void ItemPhysics::wake(const QRect &area)
+{
+    // 醒来的物体不再支撑上面的物体：沿着堆往上连锁
+    QVector<QRect> pending{area};
+    QVector<int> hit;
+    while (!pending.isEmpty())
+    {
+        const QRect a = pending.takeLast();
+        gatherSleepers(a.adjusted(0, -2, 0, 0), hit);
+        for (int idx : hit)
+        {
+            if (!sleepers[idx].w) // 同一轮里已经被叫醒
+                continue;
+            pending.push_back(sleepers[idx].rect);
+            wakeSleeper(idx);
+        }
+    }
+}
+
+void ItemPhysics::advance()
+{
+    QElapsedTimer cost;
+    cost.start();
+
+    const float elapsed = std::min<qint64>(clock.restart(), 100) / 1000.f;
+    accumulator += elapsed;
+
+    // 被拿起、回池、装备或换了父控件的物体退出模拟
+    for (int i = 0; i < bodies.size();)
+    {
+        ItemWidget *w = bodies[i].w;
+        if (!w || w->isHidden() || w->parentWidget() != world || w->isEquipped() || w->isHeld())
+        {
+            bodies[i] = bodies.last();
+            bodies.removeLast();
+            continue;
+        }
+        ++i;
+    }
+
+    int steps = 0;
+    while (accumulator >= kStep && steps < kMaxSteps && !bodies.isEmpty())
+    {
+        for (int i = 0; i < bodies.size();)
+        {
+            if (integrate(bodies[i], kStep))
+            {
+                ++i;
+                continue;
+            }
+            bodies[i] = bodies.last();
+            bodies.removeLast();
+        }
+        accumulator -= kStep;
+        ++steps;
+    }
+    if (steps == kMaxSteps)
+        accumulator = 0.f;
+
+    for (const Body &b : bodies)
+        b.w->move(b.pos.toPoint());
+
+    if (bodies.isEmpty())
+        tick.stop();
+
+    LodGovernor::instance().addWork(cost.nsecsElapsed() / 1000);
+}
+
+bool ItemPhysics::integrate(Body &b, float dt)
+{
+    if (!world)
+        return false;
+
+    QRectF r(b.pos + QPointF(b.box.topLeft()), QSizeF(b.box.size()));
+    const QRectF bounds(world->rect());
+
+    b.vel.ry() += gravity * dt;
+    const float speed = float(std::hypot(b.vel.x(), b.vel.y()));
+    if (speed > maxSpeed)
+        b.vel *= maxSpeed / speed;
+
+    // 候选障碍：角色 + 扫掠范围内的睡眠物体。一开始就和物体重叠的不算（刚从角色身上扔出来）
+    const float dx = float(b.vel.x()) * dt;
+    const float dy = float(b.vel.y()) * dt;
+    scratch.clear();
+    if (obstacle)
+    {
+        const QRectF o(obstacle());
+        if (!o.isEmpty() && !o.intersects(r))
+            scratch.push_back(o);
+    }
+    const QRect sweep = r.adjusted(-std::abs(dx) - 1, -std::abs(dy) - 1, std::abs(dx) + 1, std::abs(dy) + 1)
+                            .toAlignedRect();
+    gatherSleepers(sweep, found);
+    for (int idx : found)
+    {
+        const QRectF s(sleepers[idx].rect);
+        if (!s.intersects(r))
+            scratch.push_back(s);
+    }
+
+    // x 轴
+    r.translate(dx, 0);
+    for (const QRectF &s : scratch)
+    {
+        if (!r.intersects(s))
+            continue;
+        if (dx > 0)
+            r.moveRight(s.left());
+        else
+            r.moveLeft(s.right());
+        b.vel.rx() = -b.vel.x() * restitution;
+    }
+    if (r.left() < bounds.left())
+    {
+        r.moveLeft(bounds.left());
+        b.vel.rx() = std::abs(b.vel.x()) * restitution;
+    }
+    else if (r.right() > bounds.right())
+    {
+        r.moveRight(bounds.right());
+        b.vel.rx() = -std::abs(b.vel.x()) * restitution;
+    }
+
+    // y 轴
+    bool grounded = false;
+    r.translate(0, dy);
+    for (const QRectF &s : scratch)
+    {
+        if (!r.intersects(s))
+            continue;
+        if (dy > 0)
+        {
+            r.moveBottom(s.top());
+            grounded = true;
+        }
+        else
+        {
+            r.moveTop(s.bottom());
+        }
+        b.vel.ry() = -b.vel.y() * restitution;
+    }
+    if (r.bottom() > bounds.bottom())
+    {
+        r.moveBottom(bounds.bottom());
+        b.vel.ry() = -std::abs(b.vel.y()) * restitution;
+        grounded = true;
+    }
+    else if (r.top() < bounds.top())
+    {
+        r.moveTop(bounds.top());
+        b.vel.ry() = std::abs(b.vel.y()) * restitution;
+    }
+
+    if (grounded)
+    {
+        if (std::abs(b.vel.y()) < kBounceCutoff)
+            b.vel.ry() = 0;
+        b.vel.rx() *= std::max(0.f, 1.f - friction * dt);
+    }
+
+    b.pos = r.topLeft() - QPointF(b.box.topLeft());
+
+    if (grounded && std::abs(b.vel.x()) < kRestSpeed && b.vel.y() == 0)
+        b.restSec += dt;
+    else
+        b.restSec = 0.f;
+    if (b.restSec < kRestSec)
+        return true;
+
+    sleep(b);
+    if (onSettled)
+        onSettled(b.w);
+    return false;
+}
+
+void ItemPhysics::sleep(const Body &b)
+{
+    ItemWidget *w = b.w;
+    const QPoint p = b.pos.toPoint();
+    w->move(p);
+
+    int idx;
+    if (!freeSleepers.isEmpty())
+    {
+        idx = freeSleepers.takeLast();
+    }
+    else
+    {
+        idx = sleepers.size();
+        sleepers.push_back(Sleeper());
+        stamp.resize(sleepers.size());
+    }
+    sleepers[idx].w = w;
+    sleepers[idx].rect = QRect(p + b.box.topLeft(), b.box.size());
+    sleeperOf.insert(w, idx);
+    gridInsert(idx);
+}
+
+void ItemPhysics::wakeSleeper(int index)
+{
+    ItemWidget *w = sleepers[index].w;
+    removeSleeper(w);
+    if (!w || w->isHidden() || w->parentWidget() != world)
+        return;
+
+    Body b;
+    b.w = w;
+    b.pos = w->pos();
+    b.box = w->opaqueRect();
+    bodies.push_back(b);
+
+    if (!tick.isActive())
+    {
+        clock.restart();
+        accumulator = 0.f;
+        PowerPolicy::instance().drive(tick, kTickMs);
+    }
+}
+
+QRect ItemPhysics::removeSleeper(ItemWidget *item)
+{
+    const auto it = sleeperOf.constFind(item);
+    if (it == sleeperOf.constEnd())
+        return QRect();
+
+    const int idx = it.value();
+    sleeperOf.erase(it);
+    gridRemove(idx);
+    const QRect was = sleepers[idx].rect;
+    sleepers[idx] = Sleeper();
+    freeSleepers.push_back(idx);
+    return was;
+}
+
+void ItemPhysics::gatherSleepers(const QRect &area, QVector<int> &out)
+{
+    out.clear();
+    if (sleeperOf.isEmpty() || area.isEmpty())
+        return;
+
+    ++queryClock;
+    for (int cy = cellOf(area.top()); cy <= cellOf(area.bottom()); ++cy)
+    {
+        for (int cx = cellOf(area.left()); cx <= cellOf(area.right()); ++cx)
+        {
+            const auto cell = grid.constFind(cellKey(cx, cy));
+            if (cell == grid.constEnd())
+                continue;
+            for (int idx : *cell)
+            {
+                if (stamp[idx] == queryClock)
+                    continue;
+                stamp[idx] = queryClock;
+                if (sleepers[idx].w && sleepers[idx].rect.intersects(area))
+                    out.push_back(idx);
+            }
+        }
+    }
+}
+
+void ItemPhysics::gridInsert(int index)
+{
+    const QRect &r = sleepers[index].rect;
+    for (int cy = cellOf(r.top()); cy <= cellOf(r.bottom()); ++cy)
+        for (int cx = cellOf(r.left()); cx <= cellOf(r.right()); ++cx)
+            grid[cellKey(cx, cy)].push_back(index);
+}
+
+void ItemPhysics::gridRemove(int index)
+{
+    // 格子里的 QVector 保留容量：同一片区域反复堆放/拿走不再分配
+    const QRect &r = sleepers[index].rect;
+    for (int cy = cellOf(r.top()); cy <= cellOf(r.bottom()); ++cy)
+        for (int cx = cellOf(r.left()); cx <= cellOf(r.right()); ++cx)
+        {
+            auto cell = grid.find(cellKey(cx, cy));
+            if (cell != grid.end())
+                cell->removeOne(index);
+        }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <QHash>
+#include <QPointF>
+#include <QPointer>
+#include <QRect>
+#include <QRectF>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <functional>
+
+class ItemWidget;
+
+// ItemPhysics
+// 扔出/松手的物品：重力下落，撞窗口边和角色反弹，最后静止。
+// - 固定步长（kStep）积分，计时器只决定每次追几步；计时器按 PowerPolicy 档位运行，没有活动物体时停表
+// - 碰撞体 = 物品当前帧的不透明包围盒（AABB），先 x 后 y 分轴解算
+// - 静止一小段时间的物体进入睡眠：移出活动列表，登记进均匀网格，之后每 tick 不再计算它；
+//   下落的物体经网格查询只和附近睡眠物体碰撞（可以堆叠）
+// - 睡眠物体被拿走/回池（forget）或支撑它的角色被拖走（wake）时，压在上面的物体连锁醒来
+// 只在 GUI 线程使用。
+class ItemPhysics
+{
+public:
+    ItemPhysics();
+
+    // 角色的碰撞矩形（窗口坐标），每步查询一次：角色被拖动时也跟着变
+    void setObstacle(std::function<QRect()> fn) { obstacle = std::move(fn); }
+    // 物体入睡（位置落定）时调用，用于标记存档脏
+    void setSettledHook(std::function<void(ItemWidget *)> fn) { onSettled = std::move(fn); }
+
+    // velocity：像素/秒（窗口坐标）。item 必须是顶层窗口的直接子控件
+    void throwItem(ItemWidget *item, const QPointF &velocity);
+    void forget(ItemWidget *item);
+    // 存档恢复的物品：脚下有支撑（窗口底边、角色、已登记的睡眠物体）就原地登记成睡眠物体，
+    // 不模拟、不调 settled 钩子；悬空的照常下落。按从下到上的顺序调用时整堆都能原地入睡
+    void settle(ItemWidget *item);
+    void wake(const QRect &area); // area 内及紧贴其上方的睡眠物体重新下落
+
+    int activeCount() const { return bodies.size(); }
+    int sleepingCount() const { return sleeperOf.size(); }
+
+    float gravity = 1800.f;    // 像素/秒²
+    float restitution = 0.35f; // 反弹保留的速度比例
+    float friction = 6.f;      // 着地时水平速度每秒衰减的比例
+    float maxSpeed = 2400.f;   // 限速：每步位移小于物品尺寸，不会穿过薄障碍
+
+    static constexpr float kStep = 1.f / 120.f;
+    static constexpr int kTickMs = 16;
+    static constexpr int kCell = 64; // 网格边长（像素）
+
+private:
+    struct Body
+    {
+        QPointer<ItemWidget> w;
+        QPointF pos;  // 控件左上角（窗口坐标，浮点）
+        QPointF vel;
+        QRect box;    // 碰撞盒（控件本地坐标）
+        float restSec = 0.f;
+    };
+    QVector<Body> bodies;
+
+    struct Sleeper
+    {
+        QPointer<ItemWidget> w;
+        QRect rect; // 碰撞盒（窗口坐标）
+    };
+    QVector<Sleeper> sleepers;
+    QVector<int> freeSleepers;
+    QHash<ItemWidget *, int> sleeperOf;
+    QHash<quint64, QVector<int>> grid; // 网格坐标 -> sleepers 下标
+
+    // 查询去重：每次查询 +1，sleeper 的 stamp 等于它表示本次已收集
+    QVector<quint32> stamp;
+    quint32 queryClock = 0;
+    QVector<QRectF> scratch; // 每步的候选障碍，复用容量
+    QVector<int> found;      // 同上：网格查询结果
+
+    QPointer<QWidget> world;
+    std::function<QRect()> obstacle;
+    std::function<void(ItemWidget *)> onSettled;
+
+    QTimer tick;
+    QElapsedTimer clock;
+    float accumulator = 0.f;
+
+    void advance();
+    bool integrate(Body &b, float dt); // 返回 false 表示物体已入睡
+    void sleep(const Body &b); // 登记进睡眠网格（不调 settled 钩子）
+    void wakeSleeper(int index);
+    QRect removeSleeper(ItemWidget *item); // 返回它原来的碰撞盒；不在睡眠返回空
+    void gatherSleepers(const QRect &area, QVector<int> &out);
+    void gridInsert(int index);
+    void gridRemove(int index);
+    static quint64 cellKey(int cx, int cy) { return (quint64(quint32(cx)) << 32) | quint32(cy); }
+};
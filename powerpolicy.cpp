@@ -0,0 +1,260 @@
+#include "powerpolicy.h"
+#include "metrics.h"
+
+#include <QGuiApplication>
+#include <QCursor>
+#include <QEvent>
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <ApplicationServices/ApplicationServices.h>
+#elif defined(Q_OS_UNIX) && QT_CONFIG(xcb)
+#define EXPLDY_X11_IDLE 1
+#include <QLibrary>
+#include <QtGui/qguiapplication_platform.h>
+#endif
+
+namespace
+{
+constexpr int kPollMs = 2000;
+constexpr int kBatteryEveryNPolls = 15; // 电池状态 30s 查一次就够
+
+#ifdef EXPLDY_X11_IDLE
+// libXss 的 XScreenSaverInfo；运行时 dlopen，不在构建时依赖 X11 开发包
+struct XssInfo
+{
+    unsigned long window;
+    int state;
+    int kind;
+    unsigned long tilOrSince;
+    unsigned long idle; // 毫秒
+    unsigned long eventMask;
+};
+
+// X11 会话的系统级空闲时长（毫秒）。不是 X11（Wayland 等）或没有 libXss 时返回 -1
+qint64 x11IdleMs()
+{
+    using AllocFn = XssInfo *(*)();
+    using QueryFn = int (*)(void *display, unsigned long drawable, XssInfo *info);
+    using RootFn = unsigned long (*)(void *display);
+
+    static void *display = nullptr;
+    static unsigned long root = 0;
+    static XssInfo *info = nullptr;
+    static QueryFn query = nullptr;
+    static const bool ready = []()
+    {
+        const auto *x11 = qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
+        if (!x11 || !x11->display())
+            return false;
+        const auto alloc = reinterpret_cast<AllocFn>(QLibrary::resolve("Xss", 1, "XScreenSaverAllocInfo"));
+        const auto rootOf = reinterpret_cast<RootFn>(QLibrary::resolve("X11", 6, "XDefaultRootWindow"));
+        query = reinterpret_cast<QueryFn>(QLibrary::resolve("Xss", 1, "XScreenSaverQueryInfo"));
+        if (!alloc || !rootOf || !query)
+            return false;
+        display = x11->display();
+        root = rootOf(display);
+        info = alloc(); // 进程内一直复用，不释放
+        return info != nullptr;
+    }();
+    if (!ready || !query(display, root, info))
+        return -1;
+    return qint64(info->idle);
+}
+#endif
+}
+
+PowerPolicy &PowerPolicy::instance()
+{
+    static QPointer<PowerPolicy> policy;
+    if (!policy)
+        policy = new PowerPolicy(QCoreApplication::instance()); // 随应用退出释放
+    return *policy;
+}
+
+PowerPolicy::PowerPolicy(QObject *parent)
+    : QObject(parent)
+{
+    enabled = qEnvironmentVariable("EXPLDY_POWER").compare("off", Qt::CaseInsensitive) != 0;
+
+    Metrics::instance().gaugeFn("expldy_power_level", "Animation power level (0=full, 1=reduced, 2=paused)", QString(),
+                                [p = QPointer<PowerPolicy>(this)]()
+                                { return p ? double(int(p->current)) : 0.0; });
+
+    if (!enabled)
+        return;
+
+    lastInput.start();
+    lastCursor = QCursor::pos();
+    onBattery = readOnBattery();
+
+    // 输入事件：有人操作就立刻从空闲降档里恢复；窗口事件：可见性变化
+    qApp->installEventFilter(this);
+    connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, [this]()
+            { evaluate(); });
+
+    connect(&poll, &QTimer::timeout, this, [this, n = 0]() mutable
+            {
+        if (++n % kBatteryEveryNPolls == 0)
+            onBattery = readOnBattery();
+        evaluate(); });
+    poll.start(kPollMs);
+}
+
+const char *PowerPolicy::levelName(Level l)
+{
+    switch (l)
+    {
+    case Level::Full:
+        return "full";
+    case Level::Reduced:
+        return "reduced";
+    case Level::Paused:
+        return "paused";
+    }
+    return "full";
+}
+
+void PowerPolicy::watch(QWindow *window)
+{
+    watched = window;
+    evaluate();
+}
+
+void PowerPolicy::drive(QTimer &timer, int baseIntervalMs) const
+{
+    if (current == Level::Paused || baseIntervalMs <= 0)
+    {
+        timer.stop();
+        return;
+    }
+    timer.start(current == Level::Reduced ? baseIntervalMs * 2 : baseIntervalMs);
+}
+
+bool PowerPolicy::eventFilter(QObject *obj, QEvent *ev)
+{
+    switch (ev->type())
+    {
+    case QEvent::MouseMove:
+    case QEvent::MouseButtonPress:
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+        lastInput.restart();
+        if (idleLimited)
+            evaluate();
+        break;
+    case QEvent::Show:
+    case QEvent::Hide:
+    case QEvent::WindowStateChange:
+    case QEvent::Expose:
+        // 被监视窗口可见性变了；等这一轮事件处理完再读状态
+        if (watched && obj == watched)
+            QMetaObject::invokeMethod(this, [this]()
+                                      { evaluate(); }, Qt::QueuedConnection);
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(obj, ev);
+}
+
+bool PowerPolicy::windowVisible() const
+{
+    const auto state = qGuiApp->applicationState();
+    if (state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended)
+        return false;
+    if (!watched)
+        return true;
+    if (!watched->isVisible() || (watched->windowStates() & Qt::WindowMinimized))
+        return false;
+    // 被完全遮挡时，支持遮挡检测的平台会把窗口标成未 expose
+    return watched->isExposed();
+}
+
+qint64 PowerPolicy::userIdleMs()
+{
+    // 系统级空闲时间：别的程序里的键盘/鼠标输入也算
+#ifdef Q_OS_WIN
+    LASTINPUTINFO li;
+    li.cbSize = sizeof(li);
+    if (GetLastInputInfo(&li))
+        return qint64(GetTickCount() - li.dwTime);
+#elif defined(Q_OS_MACOS)
+    return qint64(CGEventSourceSecondsSinceLastEventType(kCGEventSourceStateCombinedSessionState,
+                                                         kCGAnyInputEventType) * 1000.0);
+#elif defined(EXPLDY_X11_IDLE)
+    const qint64 x11 = x11IdleMs();
+    if (x11 >= 0)
+        return x11;
+#endif
+    // 没有系统级空闲时间（Wayland 等）：本进程的输入事件（eventFilter）+ 全局光标动过就算有人
+    //（锁屏时光标不动，自然计入空闲；在别的程序里只打字不动鼠标会被当成空闲）
+    const QPoint c = QCursor::pos();
+    if (c != lastCursor)
+    {
+        lastCursor = c;
+        lastInput.restart();
+    }
+    return lastInput.elapsed();
+}
+
+bool PowerPolicy::readOnBattery()
+{
+#ifdef Q_OS_WIN
+    SYSTEM_POWER_STATUS s;
+    return GetSystemPowerStatus(&s) && s.ACLineStatus == 0;
+#elif defined(Q_OS_LINUX)
+    auto readLine = [](const QString &path)
+    {
+        QFile f(path);
+        return f.open(QIODevice::ReadOnly) ? QString::fromLatin1(f.readLine()).trimmed() : QString();
+    };
+
+    bool discharging = false;
+    const QDir dir("/sys/class/power_supply");
+    const auto supplies = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : supplies)
+    {
+        const QString base = dir.filePath(name);
+        const QString type = readLine(base + "/type");
+        if ((type == "Mains" || type == "USB") && readLine(base + "/online") == "1")
+            return false; // 接着电源
+        if (type == "Battery" && readLine(base + "/status") == "Discharging")
+            discharging = true;
+    }
+    return discharging;
+#else
+    return false;
+#endif
+}
+
+void PowerPolicy::evaluate()
+{
+    if (!enabled)
+        return;
+
+    const qint64 idle = userIdleMs();
+    idleLimited = idle >= reduceIdleMs;
+    Level next = Level::Full;
+    if (!windowVisible() || idle >= pauseIdleMs)
+        next = Level::Paused;
+    else if (onBattery || idle >= reduceIdleMs)
+        next = Level::Reduced;
+
+    if (next == current)
+        return;
+
+    qDebug() << "power:" << levelName(current) << "->" << levelName(next)
+             << "visible" << windowVisible() << "idle" << idle / 1000 << "s battery" << onBattery;
+    current = next;
+    emit levelChanged(current);
+}
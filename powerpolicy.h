@@ -0,0 +1,69 @@
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QPoint>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QWindow>
+
+// PowerPolicy
+// 进程级省电策略：根据窗口可见性、用户空闲时长和电池状态给出一个档位，
+// 所有动画/idle 语音计时器按档位运行：
+// - Full:    原速
+// - Reduced: 间隔翻倍（使用电池，或用户空闲超过 reduceIdleMs）
+// - Paused:  全部停掉（窗口最小化/隐藏/被完全遮挡，或用户空闲超过 pauseIdleMs——锁屏也算空闲）
+// 档位变化发 levelChanged，消费者用 drive() 按当前档位重启自己的计时器，状态（帧下标/当前 clip）不丢。
+//
+// 用户空闲：Windows 用 GetLastInputInfo、macOS 用 CGEventSource、X11 用 XScreenSaver（libXss，运行时加载），
+// 都是系统级；拿不到时（Wayland 等）看全局光标是否移动 + 本进程的键盘/鼠标事件。
+// 电池：Windows 用 GetSystemPowerStatus，Linux 读 /sys/class/power_supply。
+// 环境变量 EXPLDY_POWER=off 关闭策略（始终 Full）。
+class PowerPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Level
+    {
+        Full,
+        Reduced,
+        Paused
+    };
+
+    static PowerPolicy &instance();
+
+    // 监视顶层窗口的显示/隐藏/最小化/expose（widget 版传 windowHandle()，窗口 show() 之后才有）
+    void watch(QWindow *window);
+
+    Level level() const { return current; }
+    static const char *levelName(Level l);
+
+    // 按当前档位（重新）启动计时器：Paused 停掉，Reduced 间隔翻倍
+    void drive(QTimer &timer, int baseIntervalMs) const;
+
+    int reduceIdleMs = 5 * 60 * 1000;
+    int pauseIdleMs = 30 * 60 * 1000;
+
+signals:
+    void levelChanged(PowerPolicy::Level level);
+
+protected:
+    bool eventFilter(QObject *obj, QEvent *ev) override;
+
+private:
+    explicit PowerPolicy(QObject *parent);
+
+    Level current = Level::Full;
+    bool enabled = true;
+
+    QPointer<QWindow> watched;
+    QTimer poll; // 空闲/电池没有通知，定期查一次
+    QElapsedTimer lastInput;
+    QPoint lastCursor;
+    bool onBattery = false;
+    bool idleLimited = false; // 当前档位是否因空闲而降：是的话输入事件要立即重新评估
+
+    void evaluate();
+    bool windowVisible() const;
+    qint64 userIdleMs();
+    static bool readOnBattery();
+};
@@ -0,0 +1,30 @@
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQuickWindow>
+#include <QSGRendererInterface>
+#include "metrics.h"
+#include "powerpolicy.h"
+
+// Qt Quick 前端（expldy-quick）：场景图渲染，和 widget 版共用 expldy_core。
+// EXPLDY_QUICK_BACKEND=software 或 --software：用软件渲染后端（没有 GPU / 远程桌面时，也方便和 widget 版同条件对比）
+int main(int argc, char *argv[])
+{
+    // expldy_core 只依赖 Qt Gui，这里不需要 QApplication
+    QGuiApplication app(argc, argv);
+
+    Metrics::instance().startExport();
+
+    if (qgetenv("EXPLDY_QUICK_BACKEND") == "software" || app.arguments().contains("--software"))
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::Software);
+
+    QQmlApplicationEngine engine;
+    QObject::connect(&engine, &QQmlApplicationEngine::objectCreationFailed, &app, []()
+                     { QCoreApplication::exit(-1); }, Qt::QueuedConnection);
+    engine.loadFromModule("Expldy", "Main");
+
+    // 和 widget 版一样：最小化/遮挡/空闲/电池时降速或暂停动画
+    if (auto *win = qobject_cast<QWindow *>(engine.rootObjects().value(0)))
+        PowerPolicy::instance().watch(win);
+
+    return app.exec();
+}
@@ -0,0 +1,470 @@
+#include "quickscene.h"
+#include "interaction.h"
+#include "interner.h"
+#include "powerpolicy.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRunnable>
+#include <QSGImageNode>
+#include <QSGTexture>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    // 渲染线程上删除纹理（item 离开窗口/析构时 GUI 线程把表交过来）
+    class TextureCleanup : public QRunnable
+    {
+    public:
+        explicit TextureCleanup(QHash<const Clip *, QSGTexture *> textures) : textures(std::move(textures)) {}
+        void run() override { qDeleteAll(textures); }
+
+    private:
+        QHash<const Clip *, QSGTexture *> textures;
+    };
+
+    // 角色 idle：idle/ 下直接放帧则用它，否则 default/ 或排在最前的子目录（与 WifeLabel 的取法一致）
+    QString idleClipDir(const QString &root)
+    {
+        QDir idle(QDir(root).filePath("wife/idle"));
+        if (!idle.entryList({"*.png", "*.PNG"}, QDir::Files).isEmpty())
+            return idle.absolutePath();
+        if (idle.exists("default"))
+            return idle.absoluteFilePath("default");
+        const QStringList subs = idle.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        return subs.isEmpty() ? QString() : idle.absoluteFilePath(subs.first());
+    }
+}
+
+SpriteItem::SpriteItem(PetStage *stage, QQuickItem *parent)
+    : QQuickItem(parent), stage(stage)
+{
+    setFlag(ItemHasContents);
+    setAcceptedMouseButtons(Qt::LeftButton);
+}
+
+void SpriteItem::setClip(const ClipHandle &c, int defaultIntervalMs)
+{
+    clip = c;
+    frames = c ? c->frames : SpriteFrames();
+    defaultMs = defaultIntervalMs;
+    idx = 0;
+    nextAt = -1;
+    if (c)
+        setSize(QSizeF(c->canvas));
+    stage->prepareAtlas(c);
+    update();
+}
+
+bool SpriteItem::advance(qint64 nowMs)
+{
+    if (frames.size() < 2)
+        return false;
+    if (nextAt < 0)
+    {
+        nextAt = nowMs + frameDuration(frames, idx, defaultMs);
+        return false;
+    }
+    if (nowMs < nextAt)
+        return false;
+
+    // 暂停/降档后回来不逐帧追赶
+    if (nowMs - nextAt > 1000)
+        nextAt = nowMs;
+    while (nowMs >= nextAt)
+    {
+        idx = (idx + 1) % frames.size();
+        nextAt += frameDuration(frames, idx, defaultMs);
+    }
+    return true;
+}
+
+QRectF SpriteItem::opaqueRect() const
+{
+    return frames.isEmpty() ? QRectF() : QRectF(frames[idx].rect());
+}
+
+bool SpriteItem::contains(const QPointF &point) const
+{
+    return opaqueRect().contains(point);
+}
+
+QSGNode *SpriteItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    auto *node = static_cast<QSGImageNode *>(oldNode);
+    QSGTexture *tex = frames.isEmpty() ? nullptr : stage->textureFor(clip.get());
+    if (!tex)
+    {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node)
+    {
+        node = window()->createImageNode(); // 不拥有纹理：纹理归 PetStage，多个精灵共享
+        node->setFiltering(QSGTexture::Linear);
+    }
+    node->setTexture(tex);
+    node->setSourceRect(QRectF(stage->atlasRect(clip.get(), idx)));
+    node->setRect(QRectF(frames[idx].rect()));
+    return node;
+}
+
+void SpriteItem::mousePressEvent(QMouseEvent *event)
+{
+    grab = event->position();
+    setZ(stage->raiseZ());
+
+    // 装备挂在角色下面：拖起来时回到场景层，位置不跳
+    if (parentItem() != stage)
+    {
+        const QPointF scenePos = mapToItem(stage, QPointF(0, 0));
+        setParentItem(stage);
+        setPosition(scenePos);
+        grab = event->position();
+    }
+    setKeepMouseGrab(true);
+    event->accept();
+}
+
+void SpriteItem::mouseMoveEvent(QMouseEvent *event)
+{
+    setPosition(position() + (event->position() - grab));
+    event->accept();
+}
+
+void SpriteItem::mouseReleaseEvent(QMouseEvent *event)
+{
+    setKeepMouseGrab(false);
+    event->accept();
+    emit dropped(this);
+}
+
+PetStage::PetStage(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    voiceEat = audioCategoryTable().intern("eat");
+
+    Metrics &m = Metrics::instance();
+    frameCost = &m.counterSeconds("expldy_frame_cost_seconds_total", "Time spent producing frames (sync + render for Qt Quick, paint for widgets)",
+                                  R"(frontend="quick")");
+    framesRendered = &m.counter("expldy_frames_rendered_total", "Frames produced by the frontend", R"(frontend="quick")");
+
+    connect(&tick, &QTimer::timeout, this, &PetStage::advance);
+    connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, this, [this]()
+            {
+        // 没有动画的话下一次 advance() 自己停表
+        if (character)
+            PowerPolicy::instance().drive(tick, kTickMs); });
+}
+
+PetStage::~PetStage()
+{
+    if (attached && !textures.isEmpty())
+        attached->scheduleRenderJob(new TextureCleanup(std::exchange(textures, {})), QQuickWindow::NoStage);
+}
+
+void PetStage::componentComplete()
+{
+    QQuickItem::componentComplete();
+
+    const QString root = AssetStore::findAssetsRoot();
+    if (root.isEmpty())
+    {
+        qWarning() << "PetStage: assets folder not found";
+        return;
+    }
+
+    audio.setAssetsRoot(root);
+    audio.rebuildIndex();
+
+    character = new SpriteItem(this, this);
+    character->setClip(AssetStore::instance().clip(idleClipDir(root), QSize(200, 200)), 120);
+    connect(character, &SpriteItem::dropped, this, &PetStage::handleDropped);
+    placeCharacter();
+
+    itemDB = AssetStore::instance().itemDB(root, QSize(64, 64));
+    itemDB->whenReady(this, [this](const ItemCatalogPtr &catalog)
+                      {
+        snapshot = catalog;
+        catalogIds = QStringList(catalog->itemIds().begin(), catalog->itemIds().end());
+        emit catalogChanged(); });
+
+    clock.start();
+    PowerPolicy::instance().drive(tick, kTickMs);
+}
+
+void PetStage::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (!characterPlaced)
+        placeCharacter();
+}
+
+void PetStage::placeCharacter()
+{
+    if (!character)
+        return;
+    character->setPosition(QPointF((width() - character->width()) / 2, (height() - character->height()) / 2));
+}
+
+void PetStage::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    if (change == ItemSceneChange)
+        attachWindow(value.window);
+    QQuickItem::itemChange(change, value);
+}
+
+void PetStage::attachWindow(QQuickWindow *win)
+{
+    if (attached)
+        disconnect(attached, nullptr, this, nullptr);
+    attached = win;
+    if (!win)
+        return;
+
+    // 以下三个都在渲染线程发出（threaded render loop），直接连接
+    connect(win, &QQuickWindow::beforeSynchronizing, this, [this]()
+            { frameClock.start(); }, Qt::DirectConnection);
+    connect(win, &QQuickWindow::afterRendering, this, [this]()
+            {
+        if (!frameClock.isValid())
+            return;
+        frameCost->fetch_add(frameClock.nsecsElapsed() / 1000, std::memory_order_relaxed);
+        framesRendered->fetch_add(1, std::memory_order_relaxed);
+        frameClock.invalidate(); }, Qt::DirectConnection);
+    connect(win, &QQuickWindow::sceneGraphInvalidated, this, [this]()
+            {
+        qDeleteAll(textures);
+        textures.clear(); }, Qt::DirectConnection);
+}
+
+void PetStage::releaseResources()
+{
+    if (attached && !textures.isEmpty())
+        attached->scheduleRenderJob(new TextureCleanup(std::exchange(textures, {})), QQuickWindow::NoStage);
+    QQuickItem::releaseResources();
+}
+
+void PetStage::prepareAtlas(const ClipHandle &clip)
+{
+    // 随 catalog 增长，不淘汰（物品帧总量很小）
+    if (!clip || atlases.contains(clip.get()))
+        return;
+
+    // 行式装箱：帧按顺序从左往右摆，超过 kAtlasMaxWidth 换行。帧池下标相同的帧（往返帧、重复帧）只放一次
+    const SpriteFrames &frames = clip->frames;
+    Atlas atlas;
+    atlas.clip = clip;
+    atlas.rects.resize(frames.size());
+    QHash<int, QRect> placed;
+    QVector<int> drawn; // 需要画进图集的帧下标
+    int x = kAtlasPad, y = kAtlasPad, rowH = 0, width = 0;
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        const SpriteFrame &f = frames[i];
+        if (f.id >= 0 && placed.contains(f.id))
+        {
+            atlas.rects[i] = placed.value(f.id);
+            continue;
+        }
+        const QSize s = f.pixmap.size();
+        if (x > kAtlasPad && x + s.width() + kAtlasPad > kAtlasMaxWidth)
+        {
+            x = kAtlasPad;
+            y += rowH + kAtlasPad;
+            rowH = 0;
+        }
+        atlas.rects[i] = QRect(QPoint(x, y), s);
+        if (f.id >= 0)
+            placed.insert(f.id, atlas.rects[i]);
+        drawn.push_back(i);
+        x += s.width() + kAtlasPad;
+        rowH = std::max(rowH, s.height());
+        width = std::max(width, x);
+    }
+    if (drawn.isEmpty())
+        return;
+
+    atlas.image = QImage(width, y + rowH + kAtlasPad, QImage::Format_ARGB32_Premultiplied);
+    atlas.image.fill(Qt::transparent);
+    QPainter p(&atlas.image);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int i : std::as_const(drawn))
+        p.drawPixmap(atlas.rects[i].topLeft(), frames[i].pixmap);
+    p.end();
+
+    atlases.insert(clip.get(), std::move(atlas));
+}
+
+QSGTexture *PetStage::textureFor(const Clip *clip)
+{
+    if (QSGTexture *tex = textures.value(clip))
+        return tex;
+
+    const auto it = atlases.constFind(clip);
+    if (it == atlases.constEnd() || it->image.isNull() || !window())
+        return nullptr;
+    // 图集已经是整张纹理，不再交给场景图的共享图集
+    QSGTexture *tex = window()->createTextureFromImage(it->image);
+    textures.insert(clip, tex);
+    return tex;
+}
+
+QRect PetStage::atlasRect(const Clip *clip, int frame) const
+{
+    const auto it = atlases.constFind(clip);
+    return it == atlases.constEnd() ? QRect() : it->rects.value(frame);
+}
+
+void PetStage::advance()
+{
+    const qint64 now = clock.elapsed();
+
+    bool animated = false;
+    auto step = [&](SpriteItem *s)
+    {
+        if (!s)
+            return;
+        if (s->advance(now))
+            s->update(); // 只标脏换了帧的精灵
+        animated = animated || s->isAnimated();
+    };
+    step(character);
+    for (const auto &item : std::as_const(items))
+        step(item);
+
+    if (!animated)
+        tick.stop();
+}
+
+void PetStage::spawn(const QString &id)
+{
+    const ItemDef *def = snapshot ? snapshot->get(id) : nullptr;
+    if (!def || !def->clip)
+        return;
+
+    auto *item = new SpriteItem(this, this);
+    item->itemHandle = def->handle;
+    item->setClip(def->clip, def->frameIntervalMs);
+    item->setZ(raiseZ());
+
+    // 角色左侧，依次错开一点，不完全叠在一起
+    QPointF p(20, 20);
+    if (character)
+        p = character->position() + QPointF(-item->width() - 20, (character->height() - item->height()) / 2);
+    p.ry() += (items.size() % 5) * 12;
+    p.setX(std::clamp(p.x(), 0.0, std::max(0.0, width() - item->width())));
+    p.setY(std::clamp(p.y(), 0.0, std::max(0.0, height() - item->height())));
+    item->setPosition(p);
+
+    connect(item, &SpriteItem::dropped, this, &PetStage::handleDropped);
+    items.push_back(item);
+
+    if (item->isAnimated() && !tick.isActive())
+        PowerPolicy::instance().drive(tick, kTickMs);
+}
+
+void PetStage::clearItems()
+{
+    const auto all = items;
+    for (const auto &item : all)
+        if (item)
+            removeItem(item);
+    items.clear();
+}
+
+void PetStage::handleDropped(SpriteItem *item)
+{
+    if (item == character)
+    {
+        characterPlaced = true; // 拖过之后窗口缩放不再把角色放回中间
+        return;
+    }
+
+    const ItemCatalogPtr catalog = snapshot;
+    const ItemDef *def = catalog ? catalog->get(item->itemHandle) : nullptr;
+    if (!def)
+        return;
+
+    const DropAction action = decideDrop(*def, overlapsCharacter(item), item->equipped);
+    playDropAudio(audio, *def, action, item->spawned, voiceEat);
+
+    switch (action)
+    {
+    case DropAction::Eat:
+        removeItem(item);
+        break;
+
+    case DropAction::EquipWeapon:
+        equip(item, ItemType::Weapon);
+        break;
+
+    case DropAction::EquipShield:
+        equip(item, ItemType::Shield);
+        break;
+
+    case DropAction::DiscardEquipped:
+        removeItem(item);
+        break;
+
+    case DropAction::AnchorMonster:
+    {
+        item->spawned = true;
+
+        // 和 widget 版一样：角色右侧下方，限制在场景内
+        QPointF desired = character->position() + QPointF(character->width() + 10, character->height() - item->height());
+        desired.setX(std::clamp(desired.x(), 0.0, std::max(0.0, width() - item->width())));
+        desired.setY(std::clamp(desired.y(), 0.0, std::max(0.0, height() - item->height())));
+        item->setPosition(desired);
+        break;
+    }
+
+    case DropAction::None:
+        break;
+    }
+}
+
+bool PetStage::overlapsCharacter(SpriteItem *item) const
+{
+    if (!character || !item)
+        return false;
+
+    // 用不透明包围盒判定，透明边重叠不算
+    const QRectF c = character->mapRectToItem(this, character->opaqueRect());
+    const QRectF r = item->mapRectToItem(this, item->opaqueRect());
+    return c.intersects(r);
+}
+
+void PetStage::equip(SpriteItem *item, ItemType type)
+{
+    QPointer<SpriteItem> &slot = type == ItemType::Weapon ? equippedWeapon : equippedShield;
+    if (slot && slot != item)
+        removeItem(slot);
+    slot = item;
+
+    // 挂到角色下面：角色拖动时装备跟随。挂点与 WifeLabel 的默认挂点相同
+    item->equipped = true;
+    item->setParentItem(character);
+    item->setZ(1);
+    const QPointF anchor = type == ItemType::Weapon
+                               ? QPointF(character->width() * 0.72, character->height() * 0.60)
+                               : QPointF(character->width() * 0.30, character->height() * 0.62);
+    item->setPosition(anchor - QPointF(item->width() / 2, item->height() / 2));
+}
+
+void PetStage::removeItem(SpriteItem *item)
+{
+    if (equippedWeapon == item)
+        equippedWeapon = nullptr;
+    if (equippedShield == item)
+        equippedShield = nullptr;
+    items.removeAll(item);
+
+    // 可能正在它自己的 mouseReleaseEvent 里：延后删除
+    item->setParentItem(nullptr);
+    item->deleteLater();
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+
+#include "assetstore.h"
+#include "audiomanager.h"
+#include "itemdb.h"
+#include "metrics.h"
+
+class QSGTexture;
+class PetStage;
+
+// SpriteItem
+// Qt Quick 前端里的一个精灵（角色或物品）：一个 QSGImageNode，纹理是整个 clip 的图集（PetStage 管），
+// 换帧只改 sourceRect，不换纹理。
+// - 帧推进由 PetStage 的计时器统一调用 advance()，逐帧时长与 widget 版一致（frameDuration）
+// - 命中测试用当前帧的不透明包围盒，透明边点不到
+// - 可以直接拖动；松手发 dropped，规则由 PetStage 按 interaction.h 处理
+class SpriteItem : public QQuickItem
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("SpriteItem is created by PetStage")
+public:
+    SpriteItem(PetStage *stage, QQuickItem *parent);
+
+    void setClip(const ClipHandle &clip, int defaultMs);
+    bool advance(qint64 nowMs); // 换帧返回 true
+    bool isAnimated() const { return frames.size() > 1; }
+    QRectF opaqueRect() const;  // 本地坐标
+
+    int itemHandle = -1; // 角色为 -1
+    bool equipped = false;
+    bool spawned = false;
+
+    bool contains(const QPointF &point) const override;
+
+signals:
+    void dropped(SpriteItem *item);
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    PetStage *stage;
+    ClipHandle clip; // 保活帧池里的像素
+    SpriteFrames frames;
+    int idx = 0;
+    int defaultMs = 120;
+    qint64 nextAt = -1; // 下一次换帧的时刻（PetStage 时钟），-1 = 尚未开始
+    QPointF grab;       // 按下点（本地坐标）
+};
+
+// PetStage
+// Qt Quick 前端的场景：角色 + 从 catalog 生成的物品。和 widget 版共用 ItemDB、AudioManager、
+// interaction.h（松手判定与音效）；物理、粒子、背包对话框目前只有 widget 版。
+// - 所有精灵一个动画计时器（按 PowerPolicy 档位），只有换了帧的精灵标脏，场景图只在有变化时重画
+// - 每个 clip 的帧在 GUI 线程拼成一张图集（行式装箱，帧池下标相同的帧只放一次），纹理在渲染线程按 clip
+//   创建并共享：一个 clip 一次上传、一个纹理，同一 clip 的精灵换帧不切换纹理
+// - 每帧同步+渲染耗时计入 expldy_frame_cost_seconds_total{frontend="quick"}，和 widget 版对比
+class PetStage : public QQuickItem
+{
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(QStringList catalog READ catalog NOTIFY catalogChanged)
+public:
+    explicit PetStage(QQuickItem *parent = nullptr);
+    ~PetStage() override;
+
+    QStringList catalog() const { return catalogIds; }
+
+    Q_INVOKABLE void spawn(const QString &id);
+    Q_INVOKABLE void clearItems();
+
+    // SpriteItem 用：GUI 线程登记 clip 的图集；渲染线程（同步阶段）取纹理和帧在图集里的位置
+    void prepareAtlas(const ClipHandle &clip);
+    QSGTexture *textureFor(const Clip *clip);
+    QRect atlasRect(const Clip *clip, int frame) const;
+    qreal raiseZ() { return ++topZ; }
+
+    static constexpr int kTickMs = 16;
+    static constexpr int kAtlasMaxWidth = 2048; // 图集行宽上限，超过换行
+    static constexpr int kAtlasPad = 1;         // 帧之间留透明边，线性过滤不串色
+
+signals:
+    void catalogChanged();
+
+protected:
+    void componentComplete() override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+    void releaseResources() override;
+
+private:
+    std::shared_ptr<ItemDB> itemDB; // AssetStore 里和 widget 版共用
+    AudioManager audio;
+    ItemCatalogPtr snapshot; // 物品持有的 ItemDef 在它之内有效
+    QStringList catalogIds;
+    int voiceEat = -1;
+
+    SpriteItem *character = nullptr;
+    bool characterPlaced = false;
+    QVector<QPointer<SpriteItem>> items;
+    QPointer<SpriteItem> equippedWeapon;
+    QPointer<SpriteItem> equippedShield;
+    qreal topZ = 0;
+
+    QTimer tick;
+    QElapsedTimer clock;
+
+    struct Atlas
+    {
+        ClipHandle clip;     // 保活：表的 key 是它的地址
+        QImage image;
+        QVector<QRect> rects; // 帧下标 -> 图集里的位置
+    };
+    // GUI 线程：clip -> 图集。渲染线程只在同步阶段（GUI 线程阻塞）读取
+    QHash<const Clip *, Atlas> atlases;
+    // 渲染线程：clip -> 纹理
+    QHash<const Clip *, QSGTexture *> textures;
+
+    QPointer<QQuickWindow> attached;
+    QElapsedTimer frameClock; // 渲染线程：本帧同步开始
+    Metrics::Value *frameCost = nullptr;
+    Metrics::Value *framesRendered = nullptr;
+
+    void attachWindow(QQuickWindow *win);
+    void advance();
+    void handleDropped(SpriteItem *item);
+    bool overlapsCharacter(SpriteItem *item) const;
+    void equip(SpriteItem *item, ItemType type);
+    void removeItem(SpriteItem *item);
+    void placeCharacter();
+};
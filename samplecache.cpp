@@ -0,0 +1,193 @@
+#include "samplecache.h"
+#include "metrics.h"
+
+#include <QAudioDecoder>
+#include <QAudioBuffer>
+#include <QUrl>
+#include <QDebug>
+#include <algorithm>
+
+SampleDecoder::SampleDecoder(SampleCache *c)
+    : cache(c)
+{
+}
+
+void SampleDecoder::enqueue(const QString &path)
+{
+    queue.push_back(path);
+    if (current.isEmpty())
+        startNext();
+}
+
+void SampleDecoder::startNext()
+{
+    if (queue.isEmpty())
+        return;
+
+    // 在工作线程里创建，信号都在本线程处理。
+    // 解码失败时 error 之后往往还会来一次 finished：按 generation 只认第一次完成
+    const quint64 gen = ++generation;
+    auto *d = new QAudioDecoder(this);
+    decoder = d;
+
+    connect(d, &QAudioDecoder::bufferReady, this, [this, d, gen]()
+            {
+        if (gen != generation)
+            return;
+        const QAudioBuffer buf = d->read();
+        if (!buf.isValid())
+            return;
+        if (!currentFormat.isValid())
+            currentFormat = buf.format();
+        currentData.append(buf.constData<char>(), buf.byteCount()); });
+
+    connect(d, &QAudioDecoder::finished, this, [this, gen]()
+            { finishCurrent(gen, true); });
+
+    connect(d, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), this, [this, gen](QAudioDecoder::Error)
+            { finishCurrent(gen, false); });
+
+    current = queue.takeFirst();
+    currentFormat = QAudioFormat();
+    currentData.clear();
+
+    decoder->setSource(QUrl::fromLocalFile(current));
+    decoder->start();
+}
+
+void SampleDecoder::finishCurrent(quint64 gen, bool ok)
+{
+    if (gen != generation || current.isEmpty())
+        return;
+    ++generation; // 同一次解码的第二个完成信号（以及 stop() 里同步发出的）到这里就被忽略
+
+    QAudioDecoder *d = decoder;
+    decoder = nullptr;
+    d->stop();
+    d->deleteLater();
+
+    SampleCache *c = cache;
+    const QString path = current;
+    if (ok && currentFormat.isValid() && !currentData.isEmpty())
+    {
+        auto sample = std::make_shared<PcmSample>();
+        sample->format = currentFormat;
+        sample->data = currentData;
+        PcmSamplePtr done = std::move(sample);
+        QMetaObject::invokeMethod(c, [c, path, done]()
+                                  { c->insert(path, done); }, Qt::QueuedConnection);
+    }
+    else
+    {
+        qWarning() << "SampleCache: decode failed" << path;
+        QMetaObject::invokeMethod(c, [c, path]()
+                                  { c->markFailed(path); }, Qt::QueuedConnection);
+    }
+
+    current.clear();
+    currentData.clear();
+    startNext();
+}
+
+SampleCache::SampleCache(QObject *parent)
+    : QObject(parent)
+{
+    worker.setObjectName("SampleDecoder");
+    decoder = new SampleDecoder(this);
+    decoder->moveToThread(&worker);
+    connect(&worker, &QThread::finished, decoder, &QObject::deleteLater);
+    worker.start(QThread::LowPriority);
+}
+
+SampleCache::~SampleCache()
+{
+    worker.quit();
+    worker.wait();
+}
+
+void SampleCache::setBudgetBytes(qint64 b)
+{
+    QMutexLocker lock(&mutex);
+    budget = std::max<qint64>(0, b);
+    evictToBudget();
+}
+
+qint64 SampleCache::residentBytes() const
+{
+    QMutexLocker lock(&mutex);
+    return bytes;
+}
+
+PcmSamplePtr SampleCache::get(const QString &path)
+{
+    QMutexLocker lock(&mutex);
+    auto it = samples.constFind(path);
+    if (it == samples.constEnd())
+        return nullptr;
+
+    // 刷新 LRU：移到最后
+    lru.removeOne(path);
+    lru.push_back(path);
+    return it.value();
+}
+
+void SampleCache::prefetch(const QStringList &paths)
+{
+    QMutexLocker lock(&mutex);
+    for (const auto &path : paths)
+    {
+        if (samples.contains(path))
+        {
+            lru.removeOne(path);
+            lru.push_back(path);
+            continue;
+        }
+        if (pending.contains(path) || failed.contains(path))
+            continue;
+
+        pending.insert(path);
+        SampleDecoder *d = decoder;
+        QMetaObject::invokeMethod(d, [d, path]()
+                                  { d->enqueue(path); }, Qt::QueuedConnection);
+    }
+}
+
+void SampleCache::insert(const QString &path, PcmSamplePtr sample)
+{
+    QMutexLocker lock(&mutex);
+    pending.remove(path);
+    if (!sample || samples.contains(path))
+        return;
+
+    bytes += sample->data.size();
+    samples.insert(path, std::move(sample));
+    lru.push_back(path);
+    evictToBudget();
+}
+
+void SampleCache::markFailed(const QString &path)
+{
+    {
+        QMutexLocker lock(&mutex);
+        pending.remove(path);
+        failed.insert(path);
+    }
+
+    static Metrics::Value &decodeFailures = Metrics::instance().counter(
+        "expldy_audio_failures_total", "Audio files that failed to decode or play", R"(stage="decode")");
+    decodeFailures.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SampleCache::evictToBudget()
+{
+    // 调用方持锁
+    while (bytes > budget && !lru.isEmpty())
+    {
+        const QString victim = lru.takeFirst();
+        auto it = samples.find(victim);
+        if (it == samples.end())
+            continue;
+        bytes -= it.value()->data.size();
+        samples.erase(it);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <QObject>
+#include <QThread>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QStringList>
+#include <QByteArray>
+#include <QAudioFormat>
+#include <QMutex>
+#include <memory>
+
+class QAudioDecoder;
+class SampleCache;
+
+// 解码好的一段 PCM，不可变，可被多个播放同时持有
+struct PcmSample
+{
+    QAudioFormat format;
+    QByteArray data;
+};
+using PcmSamplePtr = std::shared_ptr<const PcmSample>;
+
+// SampleDecoder
+// 住在 SampleCache 的工作线程里，串行用 QAudioDecoder 把文件解成 PCM。
+class SampleDecoder : public QObject
+{
+public:
+    explicit SampleDecoder(SampleCache *cache);
+
+    // 只在工作线程调用
+    void enqueue(const QString &path);
+
+private:
+    SampleCache *cache;
+    QAudioDecoder *decoder = nullptr; // 每个文件一个，解完即弃：旧解码器迟到的信号不会落到下一个文件上
+    quint64 generation = 0;           // 每次开始/结束解码 +1；信号带着发出时的值，过期的直接忽略
+    QStringList queue;
+    QString current;
+    QAudioFormat currentFormat;
+    QByteArray currentData;
+
+    void startNext();
+    void finishCurrent(quint64 gen, bool ok);
+};
+
+// SampleCache
+// - get(path)：命中返回已解码 PCM（同时刷新 LRU），未命中返回空
+// - prefetch(paths)：丢给工作线程解码，解完放进缓存
+// - 总字节数超过 budget 时按 LRU 淘汰（正在播放的样本由 shared_ptr 保活，不受影响）
+// - 任何线程都可以调用（AudioManager 的音频线程查询/预取，解码结果回到本对象所在线程入库），内部一把锁
+class SampleCache : public QObject
+{
+public:
+    explicit SampleCache(QObject *parent = nullptr);
+    ~SampleCache() override;
+
+    void setBudgetBytes(qint64 bytes);
+    qint64 residentBytes() const;
+
+    PcmSamplePtr get(const QString &path);
+    void prefetch(const QStringList &paths);
+
+private:
+    QThread worker;
+    SampleDecoder *decoder = nullptr;
+
+    QHash<QString, PcmSamplePtr> samples;
+    QList<QString> lru; // 前面最旧
+    QSet<QString> pending;
+    QSet<QString> failed; // 解不了的文件不再重试，直接走 QMediaPlayer
+    mutable QMutex mutex; // 保护以上容器和 budget/bytes
+    qint64 budget = 24 * 1024 * 1024;
+    qint64 bytes = 0;
+
+    friend class SampleDecoder;
+    void insert(const QString &path, PcmSamplePtr sample);
+    void markFailed(const QString &path);
+    void evictToBudget();
+};
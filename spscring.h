@@ -0,0 +1,47 @@
+#pragma once
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+// SpscRing
+// 固定容量的单生产者/单消费者环形队列，无锁、不分配内存。
+// - push() 只能由一个线程调用，pop() 只能由另一个线程调用
+// - 满了 push() 返回 false，由调用方决定丢弃还是重试
+// - head/tail 是单调递增的计数，下标取低位；分开放在两条缓存行上，生产者和消费者互不干扰
+template <typename T, int Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing stores plain values");
+
+public:
+    bool push(const T &value)
+    {
+        const quint32 h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == quint32(Capacity))
+            return false;
+        slots[h & kMask] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &out)
+    {
+        const quint32 t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        out = slots[t & kMask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr int capacity() { return Capacity; }
+
+private:
+    static constexpr quint32 kMask = quint32(Capacity - 1);
+
+    alignas(64) std::atomic<quint32> head{0}; // 生产者写
+    alignas(64) std::atomic<quint32> tail{0}; // 消费者写
+    std::array<T, Capacity> slots{};
+};
@@ -0,0 +1,109 @@
+#include <QImage>
+#include <QRandomGenerator>
+#include <QSize>
+#include <QVector>
+#include <cstdio>
+#include <cstring>
+
+#include "cpufeatures.h"
+#include "frameblend.h"
+#include "framescaler.h"
+
+// SIMD 内核和标量内核对拍：随机输入（含不满一个向量的尾巴、各种缩小比例），结果必须逐字节相同。
+// 本机不支持的级别跳过；固定种子，失败可复现。
+namespace
+{
+    constexpr int kRounds = 300;
+
+    QImage randomImage(QRandomGenerator &rng, int w, int h)
+    {
+        QImage img(w, h, QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < h; ++y)
+        {
+            auto *px = reinterpret_cast<quint32 *>(img.scanLine(y));
+            for (int x = 0; x < w; ++x)
+            {
+                // 保持 premultiplied 合法：颜色分量不超过 alpha
+                const quint32 a = rng.bounded(256);
+                const quint32 r = a ? rng.bounded(a + 1) : 0;
+                const quint32 g = a ? rng.bounded(a + 1) : 0;
+                const quint32 b = a ? rng.bounded(a + 1) : 0;
+                px[x] = (a << 24) | (r << 16) | (g << 8) | b;
+            }
+        }
+        return img;
+    }
+
+    bool sameImage(const QImage &a, const QImage &b)
+    {
+        if (a.size() != b.size() || a.format() != b.format())
+            return false;
+        for (int y = 0; y < a.height(); ++y)
+        {
+            if (std::memcmp(a.constScanLine(y), b.constScanLine(y), size_t(a.width()) * 4) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    int checkScaler(SimdLevel level, QRandomGenerator &rng)
+    {
+        int failures = 0;
+        for (int i = 0; i < kRounds; ++i)
+        {
+            const QImage src = randomImage(rng, 1 + rng.bounded(160), 1 + rng.bounded(160));
+            const QSize target(1 + rng.bounded(96), 1 + rng.bounded(96));
+            const QImage want = scaleIntoCanvas(src, target, SimdLevel::Scalar);
+            const QImage got = scaleIntoCanvas(src, target, level);
+            if (!sameImage(want, got))
+            {
+                std::printf("scaler %s: %dx%d -> %dx%d differs from scalar\n", simdLevelName(level),
+                            src.width(), src.height(), target.width(), target.height());
+                ++failures;
+            }
+        }
+        return failures;
+    }
+
+    int checkBlend(SimdLevel level, QRandomGenerator &rng)
+    {
+        int failures = 0;
+        for (int i = 0; i < kRounds; ++i)
+        {
+            const int n = rng.bounded(1024);
+            const int t = i == 0 ? 0 : i == 1 ? 256 : rng.bounded(257); // 两端也要测
+            QVector<uchar> a(n), b(n), want(n), got(n);
+            for (int k = 0; k < n; ++k)
+            {
+                a[k] = uchar(rng.bounded(256));
+                b[k] = uchar(rng.bounded(256));
+            }
+            lerpPremultiplied(a.constData(), b.constData(), want.data(), n, t, SimdLevel::Scalar);
+            lerpPremultiplied(a.constData(), b.constData(), got.data(), n, t, level);
+            if (want != got)
+            {
+                std::printf("blend %s: %d bytes t=%d differs from scalar\n", simdLevelName(level), n, t);
+                ++failures;
+            }
+        }
+        return failures;
+    }
+}
+
+int main()
+{
+    int failures = 0;
+    for (SimdLevel level : {SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon})
+    {
+        if (!simdSupported(level))
+        {
+            std::printf("%s: not supported here, skipped\n", simdLevelName(level));
+            continue;
+        }
+        QRandomGenerator rng(20240601);
+        const int f = checkScaler(level, rng) + checkBlend(level, rng);
+        std::printf("%s: %s\n", simdLevelName(level), f == 0 ? "ok" : "MISMATCH");
+        failures += f;
+    }
+    return failures == 0 ? 0 : 1;
+}
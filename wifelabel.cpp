@@ -13,21 +13,115 @@
 #include <QSlider>
 #include <QSettings>
 #include <QRandomGenerator>
+#include <QScreen>
+#include <QJsonObject>
+#include <QPointer>
 
 #include "itemwidget.h"
+#include "interner.h"
+#include "framescaler.h"
+#include "frameblend.h"
+#include "metrics.h"
+#include "powerpolicy.h"
+#include "interaction.h"
+#include "lodgovernor.h"
 
 WifeLabel::WifeLabel(QWidget *parent)
     : QLabel(parent)
 {
-    connect(&frameTimer, &QTimer::timeout, this, [this]()
+    Interner &cats = audioCategoryTable();
+    voiceIdle = cats.intern("idle");
+    voiceHappy = cats.intern("happy");
+    voiceAngry = cats.intern("angry");
+    voiceEat = cats.intern("eat");
+    voiceHit = cats.intern("hit");
+    voiceDragging = cats.intern("dragging");
+
+    fxEat = EffectDef::preset("crumbs");
+    fxSwing = EffectDef::preset("sparks");
+    fxHit = EffectDef::preset("flash");
+    fxHit.size = 18.f;
+
+    // 动画细节档位按到角色的距离给物品降帧；角色自己始终原速
+    LodGovernor::instance().setFocusWidget(this);
+
+    Metrics &metrics = Metrics::instance();
+    Metrics::Value *framesShown = &metrics.counter("expldy_frames_shown_total", "Animation frames shown", R"(kind="character")");
+    Metrics::Value *framesSkipped = &metrics.counter("expldy_frames_skipped_total", "Character frames lost to late timer ticks");
+    connect(&frameTimer, &QTimer::timeout, this, [this, framesShown, framesSkipped]()
             {
         if (currentFrames.isEmpty()) return;
+        // 计时器迟到（主线程被占用）时只前进一帧，落下的帧计为跳帧
+        const int interval = frameTimer.interval();
+        const qint64 ms = frameClock.restart();
+        if (interval > 0 && ms >= 2 * interval)
+            framesSkipped->fetch_add(ms / interval - 1, std::memory_order_relaxed);
+        framesShown->fetch_add(1, std::memory_order_relaxed);
         frameIndex = (frameIndex + 1) % currentFrames.size();
-        setPixmap(currentFrames[frameIndex]); });
+        showFrame(currentFrames[frameIndex]);
+        // 容器给了逐帧时长：下一帧停留时间不同就换间隔
+        if (frameDuration(currentFrames, frameIndex, frameIntervalMs) != frameTickMs)
+            driveFrameTimer(); });
+
+    // 装备合成层：EXPLDY_COMPOSITE=0 关闭，装备回到独立控件绘制
+    compositeEquipment = qEnvironmentVariable("EXPLDY_COMPOSITE") != "0";
+
+    // 状态切换交叉淡化：EXPLDY_CROSSFADE=中间帧数（0 关闭）
+    bool fadeOk = false;
+    const int fadeEnv = qEnvironmentVariableIntValue("EXPLDY_CROSSFADE", &fadeOk);
+    if (fadeOk)
+        crossfadeSteps = std::clamp(fadeEnv, 0, 8);
+    fadeTimer.setTimerType(Qt::PreciseTimer);
+    connect(&fadeTimer, &QTimer::timeout, this, [this]()
+            {
+        if (fadePos < fadeFrames.size())
+        {
+            showFrame(fadeFrames[fadePos++]);
+            return;
+        }
+        fadeTimer.stop();
+        fadeFrames.clear();
+        if (!currentFrames.isEmpty())
+            startCurrentClip(); });
+
+    // 场景实体数、物理物体数：进程级汇总所有角色
+    registerProcessMetrics();
+
+    // 扔出的物品：角色的不透明范围也是障碍；落定后位置要存档
+    physics.setObstacle([this]()
+                        {
+        QWidget *w = window();
+        if (!w || !hasShownFrame)
+            return QRect();
+        const QRect r = opaqueRect();
+        return QRect(mapTo(w, r.topLeft()), r.size()); });
+    physics.setSettledHook([this](ItemWidget *)
+                           { world.markDirty(); });
 
     edgeHitCooldown.start();
     loadUserSettings();
 
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]()
+            {
+        world.flushNow();
+        qDebug() << itemPool.report(); });
+
+    // 池里新建控件时连一次信号；复用的实例沿用原连接（处理函数按 itemHandle 查定义）
+    itemPool.setCreateHook([this](ItemWidget *item)
+                           {
+        // 阶段2：拖拽物品松手时，判定是否“使用在角色身上”
+        connect(item, &ItemWidget::dropped, this, [this](ItemWidget *it)
+                { handleItemDropped(it); });
+        connect(item, &ItemWidget::dragStarted, this, [this](ItemWidget *it)
+                {
+            physics.forget(it);
+            prefetchItemAudio(itemDB->get(it->itemHandle())); });
+        // 合成进角色帧的装备换帧/被摘下：重画角色当前帧
+        connect(item, &ItemWidget::frameChanged, this, [this](ItemWidget *it)
+                {
+            if (hasShownFrame && (it == equippedWeapon || it == equippedShield))
+                showFrame(shown.base); }); });
+
     // Happy/Angry 这类“短情绪态”共用一个计时器
     happyTimer.setSingleShot(true);
     connect(&happyTimer, &QTimer::timeout, this, [this]()
@@ -40,11 +134,21 @@ WifeLabel::WifeLabel(QWidget *parent)
                     playMainState();
                 } });
 
+    // 拖动合并：单次触发，间隔按屏幕刷新率算（scheduleDragFlush）
+    dragFlushTimer.setSingleShot(true);
+    dragFlushTimer.setTimerType(Qt::PreciseTimer);
+    connect(&dragFlushTimer, &QTimer::timeout, this, [this]()
+            { flushDrag(); });
+
     // idle clip 随机切换：只在 Idle 时触发
     connect(&idleSwitchTimer, &QTimer::timeout, this, [this]()
             {
         if (mainState == State::Idle)
             switchIdleClipRandom(true); });
+
+    // 最小化/遮挡/空闲/电池：动画和 idle 语音降速或暂停
+    connect(&PowerPolicy::instance(), &PowerPolicy::levelChanged, this, [this]()
+            { applyPowerLevel(); });
 }
 
 int WifeLabel::idleSwitchIntervalMs() const
@@ -70,7 +174,16 @@ void WifeLabel::startOrStopIdleSwitchTimer()
         idleSwitchTimer.stop();
         return;
     }
-    idleSwitchTimer.start(ms);
+    // 暂停档：不再随机切 clip、不说话；恢复时重新计时
+    PowerPolicy &power = PowerPolicy::instance();
+    if (power.level() == PowerPolicy::Level::Paused)
+    {
+        idleSwitchTimer.stop();
+        return;
+    }
+    // 下一次切换会播 idle 语音：提前解码到内存
+    audio.prefetchVoice(voiceIdle);
+    power.drive(idleSwitchTimer, ms);
 }
 
 void WifeLabel::switchIdleClipRandom(bool playVoice)
@@ -118,7 +231,7 @@ void WifeLabel::switchIdleClipRandom(bool playVoice)
 
     // 切换 clip 时播放 idle 语音（只在 idle 态生效）
     if (playVoice && mainState == State::Idle)
-        audio.playVoice("idle");
+        audio.playVoice(voiceIdle);
 
     if (mainState == State::Idle)
         playMainState();
@@ -136,72 +249,138 @@ void WifeLabel::loadUserSettings()
     frequency = std::clamp(frequency, 0, 100);
 }
 
-void WifeLabel::saveUserSettings() const
+QString WifeLabel::stateName(State s)
 {
-    QSettings s("expldy", "expldy");
-    s.setValue("audio/volume", volume);
-    s.setValue("audio/frequency", frequency);
+    switch (s)
+    {
+    case State::Idle:
+        return "idle";
+    case State::Happy:
+        return "happy";
+    case State::Angry:
+        return "angry";
+    case State::Eat:
+        return "eat";
+    case State::Attack:
+        return "attack";
+    case State::Defend:
+        return "defend";
+    case State::Dragging:
+        return "dragging";
+    }
+    return "idle";
 }
 
-void WifeLabel::setTargetSize(QSize s)
+WifeLabel::State WifeLabel::stateFromName(const QString &s)
 {
-    targetSize = s;
+    if (s == "happy")
+        return State::Happy;
+    if (s == "angry")
+        return State::Angry;
+    if (s == "eat")
+        return State::Eat;
+    if (s == "attack")
+        return State::Attack;
+    if (s == "defend")
+        return State::Defend;
+    // dragging 不恢复：重启后没有按住的鼠标
+    return State::Idle;
 }
 
-QString WifeLabel::assetsRoot() const
+WorldState WifeLabel::captureWorld() const
 {
-    const QString cwd = QDir::currentPath();
-    const QString appDir = QCoreApplication::applicationDirPath();
+    WorldState st;
+    st.valid = true;
+    st.charPos = pos();
+    st.state = stateName(mainState);
+    st.volume = volume;
+    st.frequency = frequency;
 
-    const QStringList candidates = {
-        QDir(cwd).filePath("assets"),
-        QDir(appDir).filePath("assets"),
-        QDir(appDir).filePath("../assets"),
-        QDir(appDir).filePath("../../assets"),
-    };
+    QWidget *w = window();
+    if (!w)
+        return st;
 
-    for (const auto &p : candidates)
+    // 递归查找：已装备的物品是本控件的子控件，也会被找到
+    const auto widgets = w->findChildren<ItemWidget *>();
+    for (ItemWidget *it : widgets)
     {
-        if (QDir(p).exists())
-            return p;
+        if (it->isHidden())
+            continue; // 对象池里待复用的实例
+        WorldItemState is;
+        is.id = it->itemId();
+        is.pos = it->mapTo(w, QPoint(0, 0));
+        is.equipped = (it == equippedWeapon || it == equippedShield);
+        is.spawned = it->isSpawned();
+        is.hp = it->hp();
+        st.items.push_back(is);
     }
-    return {};
+    return st;
 }
 
-QPixmap WifeLabel::normalizeFrame(const QPixmap &src, const QSize &targetSize)
+void WifeLabel::applyWorld(const WorldState &st)
 {
-    if (src.isNull())
-        return QPixmap();
+    if (!st.valid)
+        return;
+
+    volume = std::clamp(st.volume, 0, 100);
+    frequency = std::clamp(st.frequency, 0, 100);
+    audio.setVolume01(volume / 100.0);
+    startOrStopIdleSwitchTimer();
 
-    QPixmap scaled = src.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    if (QWidget *p = parentWidget())
+    {
+        const int maxX = std::max(0, p->width() - width());
+        const int maxY = std::max(0, p->height() - height());
+        move(std::clamp(st.charPos.x(), 0, maxX), std::clamp(st.charPos.y(), 0, maxY));
+    }
 
-    QPixmap canvas(targetSize);
-    canvas.fill(Qt::transparent);
+    QVector<ItemWidget *> loose;
+    for (const auto &is : st.items)
+    {
+        const ItemDef *def = itemDB->get(is.id);
+        if (!def)
+            continue; // 物品库里已经没有这个物品
+        ItemWidget *item = createItem(def, is.pos);
+        item->setSpawned(is.spawned);
+        if (is.hp)
+            item->setHp(is.hp);
+        if (is.equipped && (def->type == ItemType::Weapon || def->type == ItemType::Shield))
+            equip(item, def->type);
+        else
+            loose.push_back(item);
+    }
 
-    QPainter p(&canvas);
-    int x = (targetSize.width() - scaled.width()) / 2;
-    int y = (targetSize.height() - scaled.height()) / 2;
-    p.drawPixmap(x, y, scaled);
+    // 散落的物品登记进物理的睡眠网格：之后扔下的物品能落在它们上面，拿走时压在上面的会掉下来。
+    // 从下往上登记，叠着的物品下面先有支撑
+    std::sort(loose.begin(), loose.end(), [](ItemWidget *a, ItemWidget *b)
+              { return a->y() + a->opaqueRect().bottom() > b->y() + b->opaqueRect().bottom(); });
+    for (ItemWidget *item : std::as_const(loose))
+        physics.settle(item);
 
-    return canvas;
+    // 短情绪态恢复后照常由 happyTimer 回 idle
+    mainState = stateFromName(st.state);
+    playMainState();
+    if (mainState != State::Idle)
+        happyTimer.start(800);
 }
 
-QVector<QPixmap> WifeLabel::loadFrames(const QString &dirPath) const
+void WifeLabel::setTargetSize(QSize s)
 {
-    QVector<QPixmap> frames;
-    QDir dir(dirPath);
-    if (!dir.exists())
-        return frames;
+    targetSize = s;
+}
 
-    QFileInfoList files = dir.entryInfoList({"*.png", "*.PNG"}, QDir::Files, QDir::Name);
-    for (const auto &fi : files)
-    {
-        QPixmap raw(fi.absoluteFilePath());
-        QPixmap norm = normalizeFrame(raw, targetSize);
-        if (!norm.isNull())
-            frames.push_back(norm);
-    }
-    return frames;
+QString WifeLabel::assetsRoot() const
+{
+    return AssetStore::findAssetsRoot();
+}
+
+SpriteFrames WifeLabel::loadFrames(const QString &dirPath)
+{
+    ClipHandle clip = AssetStore::instance().clip(dirPath, targetSize);
+    if (!clip)
+        return {};
+    heldClips.push_back(clip);
+    return clip->frames;
 }
 
 bool WifeLabel::loadFromAssets()
@@ -209,6 +388,7 @@ bool WifeLabel::loadFromAssets()
     const QString root = assetsRoot();
     if (root.isEmpty())
     {
+        hasShownFrame = false;
         setText("Cannot find assets/ folder");
         adjustSize();
         return false;
@@ -216,114 +396,498 @@ bool WifeLabel::loadFromAssets()
 
     const QString base = QDir(root).filePath("wife");
 
-    // --- Idle clips ---
+    heldClips.clear();
+    previewClip.reset();
+    loadSteps.clear();
+    loadStepPos = 0;
+    startupDone = false;
+
+    // --- Idle clips：idle/ 下每个子文件夹一个 clip；idle/ 下直接放 png 则是 "default" ---
     idleClips.clear();
     currentIdleClip.clear();
     lastIdleClip.clear();
+    QHash<QString, QString> idleDirs; // clip 名 -> 目录
     {
         QDir idleDir(QDir(base).filePath("idle"));
         if (idleDir.exists())
         {
             const QFileInfoList clipDirs = idleDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
             for (const auto &fi : clipDirs)
-            {
-                const QString clipName = fi.fileName();
-                const auto frames = loadFrames(fi.absoluteFilePath());
-                if (!frames.isEmpty())
-                    idleClips.insert(clipName, frames);
-            }
+                idleDirs.insert(fi.fileName(), fi.absoluteFilePath());
+            if (!idleDirs.contains("default") && !idleDir.entryList({"*.png", "*.PNG"}, QDir::Files).isEmpty())
+                idleDirs.insert("default", idleDir.absolutePath());
+        }
+    }
+    QStringList idleNames = idleDirs.keys();
+    std::sort(idleNames.begin(), idleNames.end());
 
-            // 兼容：如果 idle/ 下直接放了 png，也当成一个 clip("default")
-            const auto directFrames = loadFrames(idleDir.absolutePath());
-            if (!directFrames.isEmpty() && !idleClips.contains("default"))
-                idleClips.insert("default", directFrames);
+    // 第一像素：只解码排在最前的 idle clip 的第一帧，其余全部进加载队列
+    ClipHandle preview;
+    for (const QString &name : idleNames)
+    {
+        preview = AssetStore::instance().clip(idleDirs.value(name), targetSize, 1);
+        if (preview)
+        {
+            currentIdleClip = name;
+            break;
         }
     }
 
-    if (!idleClips.isEmpty())
+    if (!preview)
     {
-        auto keys = idleClips.keys();
-        std::sort(keys.begin(), keys.end());
-        currentIdleClip = keys.first();
-        idleFrames = idleClips.value(currentIdleClip);
+        hasShownFrame = false;
+        setText("No idle clips in assets/wife/idle/<clip>/000.png");
+        adjustSize();
+        return false;
     }
 
-    happyFrames = loadFrames(QDir(base).filePath("happy"));
-    angryFrames = loadFrames(QDir(base).filePath("angry"));
-    eatFrames = loadFrames(QDir(base).filePath("eat"));
-    attackFrames = loadFrames(QDir(base).filePath("attack"));
-    defendFrames = loadFrames(QDir(base).filePath("defend"));
-    hitFrames = loadFrames(QDir(base).filePath("hit"));
-    draggingFrames = loadFrames(QDir(base).filePath("dragging"));
+    previewClip = preview;
+    idleFrames = preview->frames;
+    idleClips.insert(currentIdleClip, idleFrames);
+
+    frameIndex = 0;
+    resize(targetSize); // 控件仍是完整画布大小：挂点/布局不变，只是透明边不再存储和绘制
+    showFrame(idleFrames[0]);
+
+    qDebug() << "assetsRoot =" << root << "scaler=" << frameScalerBackend() << "blend=" << frameBlendBackend()
+             << "first idle frame at" << Metrics::uptimeUs() / 1000 << "ms (clip" << currentIdleClip << ")";
 
-    qDebug() << "assetsRoot =" << root
+    // 世界存档在后台线程读，和素材加载并行；两边都好了才恢复（只恢复一次）
+    if (!worldRestored)
+    {
+        worldRestored = true;
+        world.loadAsync([this](const WorldState &st)
+                        {
+            pendingWorld = st;
+            worldLoaded = true;
+            if (startupDone)
+                restoreWorld(); });
+    }
+
+    // --- 其余按优先级排队，每个事件循环回合做一项 ---
+    // 1) 当前 idle clip 的完整帧
+    const QString firstIdle = currentIdleClip;
+    const QString firstIdleDir = idleDirs.value(firstIdle);
+    loadSteps.push_back([this, firstIdle, firstIdleDir]()
+                        {
+        const SpriteFrames frames = loadFrames(firstIdleDir);
+        if (!frames.isEmpty())
+        {
+            replaceStateFrames(idleFrames, frames, [this, firstIdle, frames]()
+                               { idleClips.insert(firstIdle, frames); });
+            previewClip.reset(); // 完整 clip 里也有这一帧（帧池去重），预览句柄不再需要
+        }
+        return false; });
+
+    // 物品库整体在工作线程构建，和下面的分步加载并行；发布时这边只做像素上传。
+    // 库由 AssetStore 在各角色间共用：别的角色已经加载过时只是等它发布
+    // 物品帧尺寸：先统一 64x64（后续可做成设置）
+    catalogReady = false;
+    itemDB = AssetStore::instance().itemDB(root, QSize(64, 64));
+    itemDB->whenReady(this, [this](const ItemCatalogPtr &)
+                      {
+        catalogReady = true;
+        if (loadSteps.isEmpty() && !startupDone)
+            finishStartup(); });
+
+    // 2) 音频索引：点击反馈马上要用
+    loadSteps.push_back([this, root]()
+                        {
+        audio.setAssetsRoot(root);
+        audio.rebuildIndex();
+        audio.setVolume01(volume / 100.0);
+        audio.prefetchVoice(voiceHit); // 每次点击都会播
+        return false; });
+
+    // 3) 其他状态：按触发可能性排序。到达之前 framesForState() 用 idle/happy 顶替
+    const std::pair<SpriteFrames *, const char *> states[] = {
+        {&hitFrames, "hit"},
+        {&draggingFrames, "dragging"},
+        {&happyFrames, "happy"},
+        {&angryFrames, "angry"},
+        {&eatFrames, "eat"},
+        {&attackFrames, "attack"},
+        {&defendFrames, "defend"},
+    };
+    for (const auto &st : states)
+    {
+        SpriteFrames *dst = st.first;
+        const QString dir = QDir(base).filePath(st.second);
+        loadSteps.push_back([this, dst, dir]()
+                            {
+            replaceStateFrames(*dst, loadFrames(dir));
+            return false; });
+    }
+
+    // 4) 其余 idle clip（随机切换用）
+    for (const QString &name : idleNames)
+    {
+        if (name == firstIdle)
+            continue;
+        const QString dir = idleDirs.value(name);
+        loadSteps.push_back([this, name, dir]()
+                            {
+            const SpriteFrames frames = loadFrames(dir);
+            if (!frames.isEmpty())
+                idleClips.insert(name, frames);
+            return false; });
+    }
+
+    // 5) 收尾：对象池预热、idle 切换、世界恢复（物品库还没发布的话等它发布时再做）
+    loadSteps.push_back([this]()
+                        {
+        if (catalogReady)
+            finishStartup();
+        return false; });
+
+    QTimer::singleShot(0, this, [this]()
+                       { runNextLoadStep(); });
+    return true;
+}
+
+void WifeLabel::runNextLoadStep()
+{
+    if (loadStepPos >= loadSteps.size())
+        return;
+
+    const bool again = loadSteps[loadStepPos]();
+    if (!again)
+        ++loadStepPos;
+
+    if (loadStepPos < loadSteps.size())
+        QTimer::singleShot(0, this, [this]()
+                           { runNextLoadStep(); });
+    else
+        loadSteps.clear();
+}
+
+void WifeLabel::replaceStateFrames(SpriteFrames &dst, const SpriteFrames &frames, const std::function<void()> &alsoUpdate)
+{
+    if (frames.isEmpty())
+        return;
+
+    // 当前正显示的是这组帧（或它的替身）的话，换上新帧；playHit 之类临时帧不打断
+    const bool showing = currentFrames.constData() == framesForState(mainState).constData();
+    dst = frames;
+    if (alsoUpdate)
+        alsoUpdate();
+    if (showing && currentFrames.constData() != framesForState(mainState).constData())
+        setFrames(framesForState(mainState), kDefaultFrameMs);
+}
+
+void WifeLabel::finishStartup()
+{
+    // 加载期间打开过物品栏：换上完整目录
+    if (inventoryDlg)
+        inventoryDlg->setCatalog(itemDB->snapshot());
+
+    // 让 idle 随机切换策略立即生效
+    startOrStopIdleSwitchTimer();
+
+    const qint64 readyUs = Metrics::uptimeUs();
+    Metrics::instance()
+        .gaugeSeconds("expldy_startup_complete_seconds", "Process start to all startup assets loaded")
+        .store(readyUs, std::memory_order_relaxed);
+    qDebug() << "startup complete at" << readyUs / 1000 << "ms:"
              << "idleClips=" << idleClips.size()
-             << "idleFrames=" << idleFrames.size() << "(clip" << currentIdleClip << ")"
              << "happy=" << happyFrames.size()
              << "angry=" << angryFrames.size()
              << "eat=" << eatFrames.size()
              << "attack=" << attackFrames.size()
              << "defend=" << defendFrames.size()
              << "hit=" << hitFrames.size()
-             << "dragging=" << draggingFrames.size();
+             << "dragging=" << draggingFrames.size()
+             << "items=" << itemDB->itemIds().size();
+    qDebug() << "AssetStore:" << AssetStore::instance().poolReport();
+
+    startupDone = true;
+    if (worldLoaded)
+        restoreWorld();
+}
+
+void WifeLabel::restoreWorld()
+{
+    // 存档恢复前不写盘，避免用空场景覆盖旧存档
+    world.setCapture([this]()
+                     { return captureWorld(); });
+    applyWorld(pendingWorld);
+    pendingWorld = WorldState();
+}
+
+void WifeLabel::releaseItem(ItemWidget *item)
+{
+    physics.forget(item); // 压在它上面的物品会掉下来
+    itemPool.release(item);
+}
+
+ItemWidget *WifeLabel::createItem(const ItemDef *def, const QPoint &windowPos)
+{
+    ItemWidget *item = itemPool.acquire(def, window());
+    item->setHp(def->stats.hp);
+    item->move(windowPos);
+
+    item->show();
+    item->raise();
+
+    world.markDirty();
+    return item;
+}
+
+void WifeLabel::spawnItem(int itemHandle)
+{
+    QWidget *w = window();
+    if (!w)
+        return;
+
+    // 默认生成在角色旁边（右下角一点）
+    spawnItemAt(itemHandle, mapTo(w, QPoint(width() - 20, height() - 20)));
+}
+
+ItemWidget *WifeLabel::spawnItemAt(int itemHandle, const QPoint &windowPos)
+{
+    if (!window())
+        return nullptr;
+
+    const ItemDef *def = itemDB->get(itemHandle);
+    if (!def)
+        return nullptr;
 
-    if (idleFrames.isEmpty())
+    ItemWidget *item = createItem(def, windowPos);
+
+    // 食物常被连着生成：第一次生成后在空闲时给它备一个，下次不用现场构造。
+    // 只预热实际生成过的物品（大目录下启动时全部预热会建出上万个隐藏控件）
+    if (def->type == ItemType::Food)
     {
-        setText("No idle clips in assets/wife/idle/<clip>/000.png");
-        adjustSize();
-        return false;
+        QTimer::singleShot(0, this, [this, handle = def->handle]()
+                           {
+            if (QWidget *w = window())
+                itemPool.prewarm(itemDB->get(handle), w, 1); });
     }
 
-    if (draggingFrames.isEmpty())
-        draggingFrames = idleFrames;
+    // 可选：spawn 音效（不影响阶段2“使用食物”测试；未配置的事件句柄为 -1，AudioManager 直接忽略）
+    audio.playSfx(def->audioFor(ItemEvent::ItemSpawn));
+    // enemy_spawn 建议只在“使用/生成怪物”时触发（拖到角色身上松手），避免点按钮就叫一声
+    audio.playVoice(def->audioFor(ItemEvent::ActorSpawn));
+    burstOn(item, def->effectFor(ItemEvent::ItemSpawn));
+    return item;
+}
 
-    frameIndex = 0;
-    setPixmap(idleFrames[0]);
-    resize(idleFrames[0].size());
+void WifeLabel::burstAt(const QPoint &windowPos, const EffectDef &def)
+{
+    QWidget *w = window();
+    if (!w || def.isNull())
+        return;
+    if (!particles)
+        particles = new ParticleLayer(w);
+    particles->burst(windowPos, def);
+}
 
-    // --- 阶段1：初始化音频与物品库 ---
-    audio.setAssetsRoot(root);
-    audio.rebuildIndex();
-    audio.setVolume01(volume / 100.0);
+void WifeLabel::burstOn(const QWidget *target, const EffectDef &def)
+{
+    QWidget *w = window();
+    if (w && target)
+        burstAt(target->mapTo(w, target->rect().center()), def);
+}
 
-    // 物品帧尺寸：先统一 64x64（后续可做成设置）
-    itemDB.load(root, QSize(64, 64));
+bool WifeLabel::equipItem(int itemHandle)
+{
+    const ItemDef *def = itemDB->get(itemHandle);
+    if (!def || (def->type != ItemType::Weapon && def->type != ItemType::Shield) || !window())
+        return false;
 
-    // 让 idle 随机切换策略立即生效
-    startOrStopIdleSwitchTimer();
+    ItemWidget *item = createItem(def, mapTo(window(), QPoint(0, 0)));
+    equip(item, def->type);
+    audio.playVoice(def->audioFor(ItemEvent::ActorUse));
+    audio.playSfx(def->audioFor(ItemEvent::ItemUse));
+    return true;
+}
 
+bool WifeLabel::playStateByName(const QString &name)
+{
+    const QString s = name.trimmed().toLower();
+    if (s == "idle")
+        playIdle();
+    else if (s == "happy")
+        playHappy();
+    else if (s == "angry")
+        playAngry();
+    else if (s == "eat")
+        playEat();
+    else if (s == "attack")
+        playAttack();
+    else if (s == "defend")
+        playDefend();
+    else if (s == "hit")
+        playHit();
+    else
+        return false;
     return true;
 }
 
-void WifeLabel::spawnItem(const QString &itemId)
+int WifeLabel::clearItems()
 {
     QWidget *w = window();
     if (!w)
-        return;
+        return 0;
 
-    const ItemDef *def = itemDB.get(itemId);
-    if (!def)
-        return;
+    int n = 0;
+    const auto widgets = w->findChildren<ItemWidget *>();
+    for (ItemWidget *it : widgets)
+    {
+        if (it->isHidden() || it->isEquipped())
+            continue;
+        releaseItem(it);
+        ++n;
+    }
+    if (n)
+        world.markDirty();
+    return n;
+}
 
-    auto *item = new ItemWidget(def->id, def->frames, def->frameIntervalMs, w);
+void WifeLabel::setVolume(int v)
+{
+    volume = std::clamp(v, 0, 100);
+    audio.setVolume01(volume / 100.0);
+    world.markDirty();
+}
 
-    // 默认生成在角色旁边（右下角一点）
-    QPoint p = this->mapTo(w, QPoint(width() - 20, height() - 20));
-    item->move(p);
+void WifeLabel::setFrequency(int v)
+{
+    frequency = std::clamp(v, 0, 100);
+    // frequency 控制 idle clip 随机切换间隔
+    startOrStopIdleSwitchTimer();
+    world.markDirty();
+}
 
-    item->show();
-    item->raise();
+void WifeLabel::registerProcessMetrics()
+{
+    // 同名序列只能有一个回调：每个角色各注册一份的话只有最后一个被统计。
+    // 所以只注册一次，回调对所有还活着的角色求和（QPointer 自动剔除已销毁的）
+    static QVector<QPointer<WifeLabel>> labels;
+    labels.removeAll(QPointer<WifeLabel>());
+    labels.push_back(this);
 
-    // 阶段2：拖拽物品松手时，判定是否“使用在角色身上”
-    connect(item, &ItemWidget::dropped, this, [this](ItemWidget *it)
-            { handleItemDropped(it); });
+    static const bool registered = []()
+    {
+        const auto sum = [](const auto &fn)
+        {
+            double n = 0;
+            for (const auto &l : std::as_const(labels))
+                if (l)
+                    n += fn(*l);
+            return n;
+        };
+
+        Metrics &m = Metrics::instance();
+        for (int t = 0; t < kItemTypeCount; ++t)
+        {
+            m.gaugeFn("expldy_entities", "Visible item widgets by item type",
+                      QString(R"(type="%1")").arg(itemTypeName(ItemType(t))),
+                      [sum, t]()
+                      { return sum([t](const WifeLabel &l)
+                                   { return double(l.liveItemCount(ItemType(t))); }); });
+        }
+        m.gaugeFn("expldy_physics_bodies", "Thrown items being simulated", R"(state="active")",
+                  [sum]()
+                  { return sum([](const WifeLabel &l)
+                               { return double(l.physics.activeCount()); }); });
+        m.gaugeFn("expldy_physics_bodies", "Thrown items being simulated", R"(state="sleeping")",
+                  [sum]()
+                  { return sum([](const WifeLabel &l)
+                               { return double(l.physics.sleepingCount()); }); });
+        return true;
+    }();
+    Q_UNUSED(registered);
+}
 
-    // 可选：spawn 音效（不影响阶段2“使用食物”测试）
-    if (def->audio.contains("item_spawn"))
-        audio.playSfx(def->audio.value("item_spawn"));
-    // enemy_spawn 建议只在“使用/生成怪物”时触发（拖到角色身上松手），避免点按钮就叫一声
-    if (def->audio.contains("actor_spawn"))
-        audio.playVoice(def->audio.value("actor_spawn"));
+int WifeLabel::liveItemCount(ItemType type) const
+{
+    QWidget *w = window();
+    if (!w)
+        return 0;
+
+    int n = 0;
+    const auto widgets = w->findChildren<ItemWidget *>();
+    for (ItemWidget *it : widgets)
+    {
+        if (it->isHidden())
+            continue;
+        const ItemDef *def = itemDB->get(it->itemHandle());
+        if (def && def->type == type)
+            ++n;
+    }
+    return n;
+}
+
+QJsonObject WifeLabel::statsJson() const
+{
+    std::array<int, kItemTypeCount> byType{};
+    int equipped = 0;
+    if (QWidget *w = window())
+    {
+        const auto widgets = w->findChildren<ItemWidget *>();
+        for (ItemWidget *it : widgets)
+        {
+            if (it->isHidden())
+                continue;
+            if (const ItemDef *def = itemDB->get(it->itemHandle()))
+                ++byType[int(def->type)];
+            if (it->isEquipped())
+                ++equipped;
+        }
+    }
+
+    QJsonObject entities;
+    int total = 0;
+    for (int t = 0; t < kItemTypeCount; ++t)
+    {
+        entities[itemTypeName(ItemType(t))] = byType[t];
+        total += byType[t];
+    }
+    entities["total"] = total;
+    entities["equipped"] = equipped;
+
+    QJsonObject pool;
+    pool["hits"] = double(itemPool.hits());
+    pool["misses"] = double(itemPool.misses());
+    pool["pooled"] = itemPool.pooled();
+
+    QJsonObject o;
+    o["state"] = stateName(mainState);
+    o["volume"] = volume;
+    o["frequency"] = frequency;
+    o["catalog"] = itemDB->itemIds().size();
+    o["entities"] = entities;
+    o["pool"] = pool;
+    return o;
+}
+
+void WifeLabel::prefetchItemAudio(const ItemDef *def)
+{
+    if (!def)
+        return;
+
+    switch (def->type)
+    {
+    case ItemType::Food:
+    {
+        const int actorUse = def->audioFor(ItemEvent::ActorUse);
+        audio.prefetchVoice(actorUse >= 0 ? actorUse : voiceEat);
+        audio.prefetchSfx(def->audioFor(ItemEvent::ItemUse));
+        break;
+    }
+    case ItemType::Weapon:
+    case ItemType::Shield:
+        audio.prefetchVoice(def->audioFor(ItemEvent::ActorUse));
+        audio.prefetchSfx(def->audioFor(ItemEvent::ItemUse));
+        break;
+    case ItemType::Monster:
+        audio.prefetchEnemy(def->audioFor(ItemEvent::EnemySpawn));
+        break;
+    case ItemType::Misc:
+    default:
+        break;
+    }
 }
 
 void WifeLabel::handleItemDropped(ItemWidget *item)
@@ -332,166 +896,261 @@ void WifeLabel::handleItemDropped(ItemWidget *item)
     if (!item)
         return;
 
-    const ItemDef *def = itemDB.get(item->itemId());
+    // 这次处理期间固定用同一份快照（期间的回调/重入不会看到半途替换）
+    const ItemCatalogPtr catalog = itemDB->snapshot();
+    const ItemDef *def = catalog->get(item->itemHandle());
     if (!def)
         return;
 
-    const bool onChar = overlapsCharacter(item);
+    physics.forget(item); // 点一下没拖动也会走到这里：重新扔一次，自己落回原处
 
-    switch (def->type)
+    // 无论哪种结果（吃掉/装备/丢弃/吸附），位置或物品集合都变了
+    world.markDirty();
+
+    // 判定和音效与 Qt Quick 前端共用（interaction.h），这里只执行结果
+    const DropAction action = decideDrop(*def, overlapsCharacter(item), item->isEquipped());
+    playDropAudio(audio, *def, action, item->isSpawned(), voiceEat);
+
+    switch (action)
     {
-    case ItemType::Food:
-        if (onChar)
-        {
-            // 角色+物品双音效（如果 manifest 配了）
-            if (def->audio.contains("actor_use"))
-                audio.playVoice(def->audio.value("actor_use"));
-            else
-                audio.playVoice("eat"); // 没配就默认
+    case DropAction::Eat:
+    {
+        const EffectDef &crumbs = def->effectFor(ItemEvent::ActorUse);
+        burstOn(item, crumbs.isNull() ? fxEat : crumbs);
+        burstOn(item, def->effectFor(ItemEvent::ItemUse));
 
-            if (def->audio.contains("item_use"))
-                audio.playSfx(def->audio.value("item_use"));
+        playEat();         // 已经加了 assets/wife/eat 的话就播 eat
+        releaseItem(item); // 食物消失（回池）
+        break;
+    }
 
-            playEat();           // 已经加了 assets/wife/eat 的话就播 eat
-            item->deleteLater(); // 食物消失
-        }
+    case DropAction::EquipWeapon:
+    {
+        equip(item, ItemType::Weapon); // 装备不消失
+
+        const EffectDef &swing = def->effectFor(ItemEvent::ItemUse);
+        burstOn(item, swing.isNull() ? fxSwing : swing);
+
+        // ✅ 动画反馈：优先 attack（没有 attack 帧就自动用 happy 顶替）
+        playAttack();
         break;
+    }
 
-    case ItemType::Weapon:
-        if (onChar)
-        {
-            equip(item, ItemType::Weapon); // 装备不消失
-            // 你想的话，这里也可以触发一次 attack 音效/动画作为反馈
-            if (def->audio.contains("actor_use"))
-                audio.playVoice(def->audio.value("actor_use"));
-            if (def->audio.contains("item_use"))
-                audio.playSfx(def->audio.value("item_use"));
-
-            // ✅ 动画反馈：优先 attack（没有 attack 帧就自动用 happy 顶替）
-            playAttack();
-        }
-        else
-        {
-            // 只有“曾经装备过”的武器，拖离角色才销毁
-            if (item->isEquipped())
-            {
-                if (equippedWeapon == item)
-                    equippedWeapon = nullptr;
-                item->deleteLater();
-            }
-        }
+    case DropAction::EquipShield:
+        equip(item, ItemType::Shield);
+        burstOn(item, def->effectFor(ItemEvent::ItemUse));
+
+        // ✅ 动画反馈：defend（没有 defend 帧就自动用 idle 顶替）
+        playDefend();
         break;
 
-    case ItemType::Shield:
-        if (onChar)
-        {
-            equip(item, ItemType::Shield);
-            if (def->audio.contains("actor_use"))
-                audio.playVoice(def->audio.value("actor_use"));
-            if (def->audio.contains("item_use"))
-                audio.playSfx(def->audio.value("item_use"));
-
-            // ✅ 动画反馈：defend（没有 defend 帧就自动用 idle 顶替）
-            playDefend();
-        }
-        else
-        {
-            if (item->isEquipped())
-            {
-                if (equippedShield == item)
-                    equippedShield = nullptr;
-                item->deleteLater();
-            }
-        }
+    case DropAction::DiscardEquipped:
+        if (equippedWeapon == item)
+            equippedWeapon = nullptr;
+        if (equippedShield == item)
+            equippedShield = nullptr;
+        releaseItem(item);
+        updateEquipmentLayer();
         break;
 
-    case ItemType::Monster:
-        if (onChar)
-        {
-            // ✅ 阶段1：最小闭环
-            // - 拖到角色身上：视为“生成怪物”
-            // - 播放 enemy_spawn
-            // - 将怪物吸附到角色旁边（作为后续战斗实体）
+    case DropAction::AnchorMonster:
+    {
+        // ✅ 阶段1：最小闭环
+        // - 拖到角色身上：视为“生成怪物”
+        // - 播放 enemy_spawn
+        // - 将怪物吸附到角色旁边（作为后续战斗实体）
 
-            if (!item->isSpawned())
-            {
-                if (def->audio.contains("enemy_spawn"))
-                    audio.playEnemy(def->audio.value("enemy_spawn"));
-                item->setSpawned(true);
-            }
+        if (!item->isSpawned())
+        {
+            burstOn(item, def->effectFor(ItemEvent::EnemySpawn));
+            item->setSpawned(true);
+        }
 
-            QWidget *w = window();
-            if (!w)
-                break;
+        QWidget *w = window();
+        if (!w)
+            break;
 
-            // 默认放在角色右侧下方（你之后可以像武器/盾一样做成可调挂点）
-            const QPoint charTopLeft = mapTo(w, QPoint(0, 0));
-            QPoint desired = charTopLeft + QPoint(width() + 10, height() - item->height());
+        // 默认放在角色右侧下方（你之后可以像武器/盾一样做成可调挂点）
+        const QPoint charTopLeft = mapTo(w, QPoint(0, 0));
+        QPoint desired = charTopLeft + QPoint(width() + 10, height() - item->height());
 
-            // 限制在窗口内
-            const int minX = 0;
-            const int minY = 0;
-            const int maxX = std::max(0, w->width() - item->width());
-            const int maxY = std::max(0, w->height() - item->height());
-            desired.setX(std::clamp(desired.x(), minX, maxX));
-            desired.setY(std::clamp(desired.y(), minY, maxY));
+        // 限制在窗口内
+        const int minX = 0;
+        const int minY = 0;
+        const int maxX = std::max(0, w->width() - item->width());
+        const int maxY = std::max(0, w->height() - item->height());
+        desired.setX(std::clamp(desired.x(), minX, maxX));
+        desired.setY(std::clamp(desired.y(), minY, maxY));
 
-            item->move(desired);
-            item->raise();
-        }
+        item->move(desired);
+        item->raise();
         break;
+    }
 
-    case ItemType::Misc:
-    default:
-        // 先不处理
+    case DropAction::None:
         break;
     }
+
+    // 没被吃掉/装备/吸附：带着松手速度落下去（已生成的怪物是战斗实体，留在原地）
+    QWidget *w = window();
+    if (w && item->isVisible() && item->parentWidget() == w && !item->isEquipped() && !item->isSpawned())
+        physics.throwItem(item, item->releaseVelocity());
+}
+
+void WifeLabel::showFrame(const SpriteFrame &f)
+{
+    const QRect old = hasShownFrame ? shown.rect() : rect();
+    shown = composeEquipment(f);
+    hasShownFrame = true;
+    update(old.united(shown.rect()));
+}
+
+bool WifeLabel::isComposited(const ItemWidget *item) const
+{
+    return compositeEquipment && item && item->parentWidget() == this && item->isProxy();
+}
+
+LayeredFrame WifeLabel::composeEquipment(const SpriteFrame &base) const
+{
+    LayeredFrame out;
+    out.base = base;
+    const std::pair<LayeredFrame::Layer *, ItemWidget *> layers[] = {{&out.shield, equippedShield}, {&out.weapon, equippedWeapon}};
+    for (const auto &[layer, item] : layers)
+    {
+        const SpriteFrame *f = isComposited(item) ? item->currentFrame() : nullptr;
+        if (!f)
+            continue;
+        layer->frame = *f; // 帧池 pixmap 隐式共享，不拷贝像素
+        layer->pos = item->pos();
+        layer->present = true;
+    }
+    return out;
+}
+
+void WifeLabel::updateEquipmentLayer()
+{
+    // 仍挂在角色身上的装备进入代理模式（不再自己绘制），然后按新组合重画当前帧
+    for (ItemWidget *it : {equippedWeapon, equippedShield})
+        if (it && it->parentWidget() == this)
+            it->setProxy(compositeEquipment);
+    if (hasShownFrame)
+        showFrame(shown.base);
+}
+
+QRect WifeLabel::opaqueRect() const
+{
+    // 按角色本身的帧算：合成进来的装备不扩大角色的命中/重叠范围
+    return hasShownFrame ? shown.base.rect() : rect();
 }
 
-void WifeLabel::setFrames(const QVector<QPixmap> &frames, int intervalMs)
+void WifeLabel::paintEvent(QPaintEvent *event)
+{
+    if (!hasShownFrame)
+    {
+        QLabel::paintEvent(event); // 出错提示文字
+        return;
+    }
+    QPainter p(this);
+    shown.draw(p);
+
+    if (!firstPixelReported)
+    {
+        firstPixelReported = true;
+        const qint64 us = Metrics::uptimeUs();
+        Metrics::instance()
+            .gaugeSeconds("expldy_startup_first_pixel_seconds", "Process start to the first character frame painted")
+            .store(us, std::memory_order_relaxed);
+        qDebug() << "time to first pixel:" << us / 1000 << "ms";
+    }
+}
+
+void WifeLabel::setFrames(const SpriteFrames &frames, int intervalMs)
 {
     frameTimer.stop();
+    fadeTimer.stop();
+    fadeFrames.clear();
+
+    // 换到另一组帧且画面确实不同：先从当前画面淡到新 clip 第一帧
+    const bool fade = crossfadeSteps > 0 && hasShownFrame && !frames.isEmpty() &&
+                      frames.constData() != currentFrames.constData() &&
+                      (shown.base.id < 0 || shown.base.id != frames[0].id);
 
     currentFrames = frames;
     frameIndex = 0;
+    frameIntervalMs = intervalMs;
 
     if (currentFrames.isEmpty())
         return;
 
-    setPixmap(currentFrames[0]);
+    if (fade)
+        fadeFrames = AssetStore::instance().crossfade(shown.base, currentFrames[0], crossfadeSteps);
+    if (!fadeFrames.isEmpty())
+    {
+        fadePos = 0;
+        showFrame(fadeFrames[fadePos++]);
+        fadeTimer.start(crossfadeStepMs);
+        return;
+    }
+
+    startCurrentClip();
+}
 
+void WifeLabel::startCurrentClip()
+{
+    showFrame(currentFrames[frameIndex]);
     if (currentFrames.size() > 1)
-        frameTimer.start(intervalMs);
+    {
+        driveFrameTimer();
+        frameClock.start();
+    }
 }
 
-void WifeLabel::playMainState()
+void WifeLabel::driveFrameTimer()
+{
+    frameTickMs = frameDuration(currentFrames, frameIndex, frameIntervalMs);
+    PowerPolicy::instance().drive(frameTimer, frameTickMs);
+}
+
+void WifeLabel::applyPowerLevel()
+{
+    // 淡化中：播完后 startCurrentClip() 会按新档位启动
+    if (currentFrames.size() > 1 && !fadeTimer.isActive())
+    {
+        driveFrameTimer();
+        frameClock.start(); // 暂停期间不算跳帧
+    }
+    startOrStopIdleSwitchTimer();
+}
+
+const SpriteFrames &WifeLabel::framesForState(State s) const
 {
-    switch (mainState)
+    // 缺帧（素材没有，或启动时还没加载到）时的替身
+    switch (s)
     {
     case State::Idle:
-        setFrames(idleFrames, 80);
         break;
     case State::Happy:
-        setFrames(happyFrames.isEmpty() ? idleFrames : happyFrames, 80);
-        break;
+        return happyFrames.isEmpty() ? idleFrames : happyFrames;
     case State::Angry:
-        setFrames(angryFrames.isEmpty() ? idleFrames : angryFrames, 80);
-        break;
+        return angryFrames.isEmpty() ? idleFrames : angryFrames;
     case State::Eat:
-        setFrames(eatFrames.isEmpty() ? (happyFrames.isEmpty() ? idleFrames : happyFrames) : eatFrames, 80);
-        break;
+        return eatFrames.isEmpty() ? (happyFrames.isEmpty() ? idleFrames : happyFrames) : eatFrames;
     case State::Attack:
         // attack 动画不存在就先用 happy 顶替（后续你补 assets/wife/attack 即可）
-        setFrames(attackFrames.isEmpty() ? (happyFrames.isEmpty() ? idleFrames : happyFrames) : attackFrames, 80);
-        break;
+        return attackFrames.isEmpty() ? (happyFrames.isEmpty() ? idleFrames : happyFrames) : attackFrames;
     case State::Defend:
         // defend 动画不存在就先用 idle 顶替
-        setFrames(defendFrames.isEmpty() ? idleFrames : defendFrames, 80);
-        break;
+        return defendFrames.isEmpty() ? idleFrames : defendFrames;
     case State::Dragging:
-        setFrames(draggingFrames.isEmpty() ? idleFrames : draggingFrames, 80);
-        break;
+        return draggingFrames.isEmpty() ? idleFrames : draggingFrames;
     }
+    return idleFrames;
+}
+
+void WifeLabel::playMainState()
+{
+    world.markDirty();
+    setFrames(framesForState(mainState), kDefaultFrameMs);
 }
 
 void WifeLabel::playIdle()
@@ -502,7 +1161,7 @@ void WifeLabel::playIdle()
 
 void WifeLabel::playHappy()
 {
-    audio.playRandom("happy");
+    audio.playVoice(voiceHappy);
     mainState = State::Happy;
     playMainState();
 
@@ -513,7 +1172,7 @@ void WifeLabel::playHappy()
 
 void WifeLabel::playAngry()
 {
-    audio.playRandom("angry");
+    audio.playVoice(voiceAngry);
     mainState = State::Angry;
     playMainState();
 
@@ -553,7 +1212,7 @@ void WifeLabel::playDefend()
 
 void WifeLabel::playHit(int ms)
 {
-    audio.playRandom("hit");
+    audio.playVoice(voiceHit);
     if (hitFrames.isEmpty())
         return;
 
@@ -565,6 +1224,13 @@ void WifeLabel::playHit(int ms)
 
 void WifeLabel::mousePressEvent(QMouseEvent *event)
 {
+    // 透明边不算点中角色
+    if (event->button() == Qt::LeftButton && !opaqueRect().contains(event->position().toPoint()))
+    {
+        event->ignore();
+        return;
+    }
+
     if (event->button() == Qt::LeftButton)
     {
         pressedLeft = true;
@@ -572,8 +1238,12 @@ void WifeLabel::mousePressEvent(QMouseEvent *event)
 
         pressGlobalPos = event->globalPosition().toPoint();
         labelStartPos = pos();
+        if (QWidget *w = window())
+            restingArea = QRect(mapTo(w, opaqueRect().topLeft()), opaqueRect().size());
 
         playHit(200); // 轻触反馈
+        if (QWidget *w = window())
+            burstAt(mapTo(w, event->position().toPoint()), fxHit);
     }
 
     QLabel::mousePressEvent(event);
@@ -596,18 +1266,37 @@ void WifeLabel::mouseMoveEvent(QMouseEvent *event)
         dragging = true;
 
         mainState = State::Dragging;
-        audio.playRandom("dragging");
+        audio.playVoice(voiceDragging);
         playMainState();
         happyTimer.stop();
     }
 
-    QPoint newPos = labelStartPos + delta;
+    // 高回报率鼠标每秒上千个 move：这里只记最新位置，真正的 move 合并到下一个刷新周期
+    latestDragGlobal = nowGlobal;
+    scheduleDragFlush();
+}
+
+void WifeLabel::scheduleDragFlush()
+{
+    if (dragFlushTimer.isActive())
+        return;
+
+    const QScreen *sc = screen();
+    const qreal hz = sc ? sc->refreshRate() : 60.0;
+    dragFlushTimer.start(std::max(1, int(1000.0 / std::max<qreal>(hz, 1.0))));
+}
+
+void WifeLabel::flushDrag()
+{
+    if (!dragging)
+        return;
+
+    QPoint newPos = labelStartPos + (latestDragGlobal - pressGlobalPos);
 
     QWidget *p = parentWidget();
     if (!p)
     {
         move(newPos);
-        snapEquippedItems();
         return;
     }
 
@@ -626,8 +1315,8 @@ void WifeLabel::mouseMoveEvent(QMouseEvent *event)
     newPos.setX(std::clamp(newPos.x(), minX, maxX));
     newPos.setY(std::clamp(newPos.y(), minY, maxY));
 
-    move(newPos);
-    snapEquippedItems();
+    move(newPos); // 装备是子控件，一起移动
+    world.markDirty();
 
     const int cooldownMs = 600;
     if (hitEdge && edgeHitCooldown.elapsed() > cooldownMs)
@@ -641,6 +1330,16 @@ void WifeLabel::mouseReleaseEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton)
     {
+        // 松手前把还没合并进去的最后位置落地
+        if (dragFlushTimer.isActive())
+        {
+            dragFlushTimer.stop();
+            flushDrag();
+        }
+        // 角色被拖走：原来放在它头上的物品掉下来
+        if (dragging && !restingArea.isNull())
+            physics.wake(restingArea);
+        restingArea = QRect();
         pressedLeft = false;
         dragging = false;
         happyTimer.stop();
@@ -654,6 +1353,7 @@ void WifeLabel::mouseReleaseEvent(QMouseEvent *event)
 void WifeLabel::contextMenuEvent(QContextMenuEvent *event)
 {
     // 右键优先：强制结束拖动/回 idle（你选的 A）
+    dragFlushTimer.stop();
     pressedLeft = false;
     dragging = false;
     mainState = State::Idle;
@@ -668,13 +1368,13 @@ void WifeLabel::contextMenuEvent(QContextMenuEvent *event)
             {
         if (!inventoryDlg) {
             inventoryDlg = new InventoryDialog(window());
-            inventoryDlg->setDB(&itemDB);
-            connect(inventoryDlg, &InventoryDialog::spawnRequested, this, [this](const QString& id) {
-                spawnItem(id);
+            inventoryDlg->setCatalog(itemDB->snapshot());
+            connect(inventoryDlg, &InventoryDialog::spawnRequested, this, [this](int handle) {
+                spawnItem(handle);
             });
         } else {
-            // 如果物品库已刷新（未来热重载），这里可以重建 UI
-            inventoryDlg->setDB(&itemDB);
+            // 物品库发布过新快照的话换上它（同一份快照则只是同步一次）
+            inventoryDlg->setCatalog(itemDB->snapshot());
         }
 
         inventoryDlg->show();
@@ -721,10 +1421,7 @@ void WifeLabel::contextMenuEvent(QContextMenuEvent *event)
         audio.setVolume01(volume / 100.0);
 
         connect(slider, &QSlider::valueChanged, this, [this](int v)
-                {
-                    volume = v;
-                    saveUserSettings();
-                    audio.setVolume01(volume / 100.0); });
+                { setVolume(v); });
     }
 
     // Frequency slider
@@ -738,11 +1435,7 @@ void WifeLabel::contextMenuEvent(QContextMenuEvent *event)
         audioMenu->addAction(wa);
 
         connect(slider, &QSlider::valueChanged, this, [this](int v)
-                {
-                    frequency = v;
-                    saveUserSettings();
-                    // frequency 控制 idle clip 随机切换间隔
-                    startOrStopIdleSwitchTimer(); });
+                { setFrequency(v); });
     }
 
     menu.addSeparator();
@@ -761,19 +1454,16 @@ bool WifeLabel::overlapsCharacter(QWidget *item) const
     if (!w || !item)
         return false;
 
-    QRect charRect(mapTo(w, QPoint(0, 0)), size());
+    // 用不透明包围盒判定，透明边重叠不算
+    QRect charRect = opaqueRect().translated(mapTo(w, QPoint(0, 0)));
     QRect itemRect(item->mapTo(w, QPoint(0, 0)), item->size());
+    if (auto *iw = qobject_cast<ItemWidget *>(item))
+        itemRect = iw->opaqueRect().translated(iw->mapTo(w, QPoint(0, 0)));
     return charRect.intersects(itemRect);
 }
 
 void WifeLabel::snapEquippedItems()
 {
-    QWidget *w = window();
-    if (!w)
-        return;
-
-    const QPoint charTopLeft = mapTo(w, QPoint(0, 0));
-
     // 没有显式设置挂点时，用“相对角色尺寸”的默认挂点。
     // 这样 targetSize / 角色尺寸变化时，武器/盾不会飞到右下角很远。
     const QPoint weaponAnchor = (weaponOffset.x() < 0 || weaponOffset.y() < 0)
@@ -783,16 +1473,11 @@ void WifeLabel::snapEquippedItems()
                                    ? QPoint(int(width() * 0.30), int(height() * 0.62))
                                    : shieldOffset;
 
+    // 装备是本控件的子控件：坐标就是角色本地坐标
     if (equippedWeapon)
-    {
-        equippedWeapon->move(charTopLeft + weaponAnchor - QPoint(equippedWeapon->width() / 2, equippedWeapon->height() / 2));
-        equippedWeapon->raise();
-    }
+        equippedWeapon->move(weaponAnchor - QPoint(equippedWeapon->width() / 2, equippedWeapon->height() / 2));
     if (equippedShield)
-    {
-        equippedShield->move(charTopLeft + shieldAnchor - QPoint(equippedShield->width() / 2, equippedShield->height() / 2));
-        equippedShield->raise();
-    }
+        equippedShield->move(shieldAnchor - QPoint(equippedShield->width() / 2, equippedShield->height() / 2));
 }
 
 void WifeLabel::equip(ItemWidget *item, ItemType type)
@@ -802,18 +1487,26 @@ void WifeLabel::equip(ItemWidget *item, ItemType type)
 
     item->setEquipped(true);
 
+    // 挂到角色下面：之后角色移动一次，装备自动跟随，不再单独 move/raise
+    if (item->parentWidget() != this)
+    {
+        item->setParent(this);
+        item->show();
+    }
+
     if (type == ItemType::Weapon)
     {
         if (equippedWeapon && equippedWeapon != item)
-            equippedWeapon->deleteLater();
+            releaseItem(equippedWeapon);
         equippedWeapon = item;
     }
     else if (type == ItemType::Shield)
     {
         if (equippedShield && equippedShield != item)
-            equippedShield->deleteLater();
+            releaseItem(equippedShield);
         equippedShield = item;
     }
 
     snapEquippedItems();
+    updateEquipmentLayer();
 }
@@ -11,10 +11,18 @@
 #include <QString>
 #include <QMouseEvent>
 #include <QContextMenuEvent>
+#include <QPointer>
+#include <functional>
 
 #include "audiomanager.h"
 #include "itemdb.h"
 #include "inventorydialog.h"
+#include "assetstore.h"
+#include "worldstore.h"
+#include "itempool.h"
+#include "layeredframe.h"
+#include "particles.h"
+#include "physics.h"
 
 class ItemWidget;
 
@@ -24,7 +32,7 @@ public:
     explicit WifeLabel(QWidget *parent = nullptr);
 
     void setTargetSize(QSize s);
-    bool loadFromAssets(); // 从 assets/wife/... 加载帧
+    bool loadFromAssets(); // 从 assets/wife/... 加载帧：只同步解码第一帧，其余在事件循环里分步加载
 
     void playIdle();
     void playHappy();
@@ -34,13 +42,27 @@ public:
     void playDefend();
     void playHit(int ms = 200); // 短反馈：播 hit 后回到主状态
 
+    // 脚本/自动化入口（ControlServer 用），和右键菜单、物品栏走同一套逻辑
+    ItemWidget *spawnItemAt(int itemHandle, const QPoint &windowPos); // 同物品栏生成，但指定窗口坐标
+    bool equipItem(int itemHandle);                                   // 生成并直接装备（只限 weapon/shield）
+    bool playStateByName(const QString &name);                        // "idle"/"happy"/.../"hit"
+    int clearItems();                                                 // 回收所有未装备的物品，返回个数
+    void setVolume(int v);                                            // 0-100
+    void setFrequency(int v);                                         // 0-100
+    ItemCatalogPtr catalog() const { return itemDB->snapshot(); }
+    QJsonObject statsJson() const; // 实体数量（按 ItemType）、对象池、当前状态等
+    int liveItemCount(ItemType type) const; // 场景里可见的物品（含装备中的）
+
 protected:
+    void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void contextMenuEvent(QContextMenuEvent *event) override;
 
 private:
+    void registerProcessMetrics(); // 进程级汇总指标：只注册一次，回调对所有角色求和
+
     enum class State
     {
         Idle,
@@ -55,41 +77,105 @@ private:
 
     QSize targetSize{400, 600};
 
-    QVector<QPixmap> idleFrames;
+    // 帧都已裁到不透明包围盒（SpriteFrame::offset 记录在 targetSize 画布里的位置）
+    SpriteFrames idleFrames;
     // Idle clip 系统：idle/ 下每个子文件夹 = 一个 clip
-    QHash<QString, QVector<QPixmap>> idleClips;
+    QHash<QString, SpriteFrames> idleClips;
     QString currentIdleClip;
     QString lastIdleClip;
 
-    QVector<QPixmap> happyFrames;
-    QVector<QPixmap> angryFrames;
-    QVector<QPixmap> eatFrames;
-    QVector<QPixmap> attackFrames;
-    QVector<QPixmap> defendFrames;
-    QVector<QPixmap> hitFrames;
-    QVector<QPixmap> draggingFrames;
+    SpriteFrames happyFrames;
+    SpriteFrames angryFrames;
+    SpriteFrames eatFrames;
+    SpriteFrames attackFrames;
+    SpriteFrames defendFrames;
+    SpriteFrames hitFrames;
+    SpriteFrames draggingFrames;
 
-    QVector<QPixmap> currentFrames;
+    SpriteFrames currentFrames;
     int frameIndex = 0;
 
+    // 上面各帧数组都与 AssetStore 里的 Clip 隐式共享；这里持有句柄，
+    // 保证同一进程里其他 WifeLabel 加载相同素材时直接复用
+    QVector<ClipHandle> heldClips;
+    ClipHandle previewClip; // 启动时只解码了第一帧的 idle clip，完整 clip 到达后释放
+
+    // 渐进式启动：loadFromAssets 只解码第一个 idle clip 的第一帧就返回（窗口立刻能显示），
+    // 其余素材按优先级排队，每个事件循环回合执行一步；返回 true 表示这一步还要再跑一回合
+    QVector<std::function<bool()>> loadSteps;
+    int loadStepPos = 0;
+    bool startupDone = false;
+    bool catalogReady = false; // 物品库在工作线程构建，和上面的步骤并行
+    bool firstPixelReported = false;
+    void runNextLoadStep();
+    void finishStartup();
+    // 某个状态的帧到达：如果正显示它的替身帧，就地换成真帧
+    void replaceStateFrames(SpriteFrames &dst, const SpriteFrames &frames, const std::function<void()> &alsoUpdate = {});
+    const SpriteFrames &framesForState(State s) const; // 缺帧时按 idle/happy 顶替
+
     // Timer
     QTimer frameTimer;
+    QElapsedTimer frameClock; // 上一帧 tick 的时刻：tick 迟到超过一个间隔就计为跳帧
+    static constexpr int kDefaultFrameMs = 80; // 素材没给帧时长时的主状态帧间隔
+    int frameIntervalMs = kDefaultFrameMs;     // 当前 clip 的默认间隔；帧自带时长（durationMs）时以帧为准
+    int frameTickMs = kDefaultFrameMs;         // 计时器当前按哪个原速间隔运行；实际间隔由 PowerPolicy 档位决定
+    void driveFrameTimer();                    // 按当前帧时长 + 档位（重新）启动 frameTimer
     QTimer happyTimer;
     QTimer idleSwitchTimer;
 
     // 阶段1：音频（三通道）+ 物品库 + 物品栏
     AudioManager audio;
-    ItemDB itemDB;
+    std::shared_ptr<ItemDB> itemDB = std::make_shared<ItemDB>(); // AssetStore 里共用的一份；加载前是空库
     InventoryDialog *inventoryDlg = nullptr;
 
-    void spawnItem(const QString &itemId);
+    // 常用 voice category 句柄（audioCategoryTable()），构造时 intern 一次
+    int voiceIdle = -1;
+    int voiceHappy = -1;
+    int voiceAngry = -1;
+    int voiceEat = -1;
+    int voiceHit = -1;
+    int voiceDragging = -1;
+
+    // 粒子：整个窗口一层，第一次发射时创建。manifest 没配 effects 时用下面的默认
+    QPointer<ParticleLayer> particles;
+    EffectDef fxEat;   // 吃东西：碎屑
+    EffectDef fxSwing; // 装备武器（挥剑）：火花
+    EffectDef fxHit;   // 点中角色：受击闪光
+    void burstAt(const QPoint &windowPos, const EffectDef &def);
+    void burstOn(const QWidget *w, const EffectDef &def); // 以控件中心为发射点
+
+    // 物品控件对象池：吃掉/丢弃的物品回池而不是 deleteLater
+    ItemPool itemPool;
+    // 扔出/松手的物品下落、反弹、堆叠
+    ItemPhysics physics;
+    void releaseItem(ItemWidget *item); // 退出物理模拟再回池
+
+    void spawnItem(int itemHandle);
+    ItemWidget *createItem(const ItemDef *def, const QPoint &windowPos); // 只建控件+连信号，不播音
     void handleItemDropped(ItemWidget *item);
+    void prefetchItemAudio(const ItemDef *def); // 物品被拖起时预取松手可能触发的音效
 
     QString assetsRoot() const;
-    QVector<QPixmap> loadFrames(const QString &dirPath) const;
-    static QPixmap normalizeFrame(const QPixmap &src, const QSize &targetSize);
-
-    void setFrames(const QVector<QPixmap> &frames, int intervalMs);
+    SpriteFrames loadFrames(const QString &dirPath);
+
+    void setFrames(const SpriteFrames &frames, int intervalMs);
+    void startCurrentClip(); // 显示 currentFrames[frameIndex] 并按档位启动 frameTimer
+
+    // 状态切换交叉淡化：setFrames 时从当前画面淡到新 clip 第一帧。中间帧由 AssetStore::crossfade()
+    // 生成（SIMD premultiplied lerp，按帧对缓存），fadeTimer 逐张显示，播完再开始新 clip
+    int crossfadeSteps = 3; // 0 = 硬切
+    static constexpr int crossfadeStepMs = 25;
+    SpriteFrames fadeFrames;
+    int fadePos = 0;
+    QTimer fadeTimer;
+    void applyPowerLevel(); // 按 PowerPolicy 当前档位重启帧/idle 切换计时器，帧下标和 clip 不变
+
+    // 当前显示的画面：paintEvent 逐层 blit，只重画前后两次包围盒的并集。
+    // shown.base 是角色本身的帧，其余两层是挂在身上的装备（没有合成时不存在）
+    LayeredFrame shown;
+    bool hasShownFrame = false;
+    void showFrame(const SpriteFrame &f);
+    QRect opaqueRect() const; // 当前帧不透明范围（本地坐标）；无帧时为整个控件
     void playMainState();
 
     int idleSwitchIntervalMs() const;
@@ -101,8 +187,15 @@ private:
     bool dragging = false;
     QPoint pressGlobalPos;
     QPoint labelStartPos;
+    QRect restingArea; // 按下时角色的不透明范围（窗口坐标）：拖走后叫醒放在上面的物品
     int dragThresholdPx = 8;
 
+    // 拖动合并：mouseMove 只记录最新光标位置，每个显示刷新周期最多真正 move 一次
+    QPoint latestDragGlobal;
+    QTimer dragFlushTimer;
+    void scheduleDragFlush();
+    void flushDrag();
+
     // 撞边 hit 冷却
     QElapsedTimer edgeHitCooldown;
 
@@ -110,8 +203,18 @@ private:
     int volume = 70;    // 0-100
     int frequency = 50; // 0-100（说话频率/健谈程度）
 
-    void loadUserSettings();
-    void saveUserSettings() const;
+    void loadUserSettings(); // 旧版 QSettings（只读，作为没有世界存档时的初值）
+
+    // 世界状态持久化：位置/状态/物品/装备/血量/音量频率，防抖后后台线程写 journal
+    WorldStore world;
+    bool worldRestored = false;
+    bool worldLoaded = false; // 存档读完；素材也加载完（startupDone）才恢复
+    WorldState pendingWorld;
+    void restoreWorld();
+    WorldState captureWorld() const;
+    void applyWorld(const WorldState &st);
+    static QString stateName(State s);
+    static State stateFromName(const QString &s);
 
     ItemWidget *equippedWeapon = nullptr;
     ItemWidget *equippedShield = nullptr;
@@ -121,7 +224,15 @@ private:
     QPoint weaponOffset = QPoint(-1, -1);
     QPoint shieldOffset = QPoint(-1, -1);
 
-    void snapEquippedItems(); // 角色移动时让装备跟随
+    // 装备是角色的子控件，角色 move 时自动跟随；这里只在装备/尺寸变化时摆到挂点
+    void snapEquippedItems();
+
+    // 装备合成层：挂在角色身上的武器/盾作为角色画面的额外层画出（LayeredFrame），
+    // 装备控件退为不绘制的点击代理；摘下或卸下即回到普通帧
+    bool compositeEquipment = true;
+    bool isComposited(const ItemWidget *item) const;
+    LayeredFrame composeEquipment(const SpriteFrame &base) const;
+    void updateEquipmentLayer();
     bool overlapsCharacter(QWidget *item) const;
     void equip(ItemWidget *item, ItemType type);
 };
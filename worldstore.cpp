@@ -0,0 +1,199 @@
+#include "worldstore.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+
+QJsonObject WorldState::toJson() const
+{
+    QJsonObject o;
+    o["char"] = QJsonArray{charPos.x(), charPos.y()};
+    o["state"] = state;
+    o["volume"] = volume;
+    o["frequency"] = frequency;
+
+    QJsonArray arr;
+    for (const auto &it : items)
+    {
+        QJsonObject io;
+        io["id"] = it.id;
+        io["pos"] = QJsonArray{it.pos.x(), it.pos.y()};
+        if (it.equipped)
+            io["equipped"] = true;
+        if (it.spawned)
+            io["spawned"] = true;
+        if (it.hp)
+            io["hp"] = it.hp;
+        arr.push_back(io);
+    }
+    o["items"] = arr;
+    return o;
+}
+
+WorldState WorldState::fromJson(const QJsonObject &o)
+{
+    WorldState st;
+    st.valid = true;
+
+    const QJsonArray c = o["char"].toArray();
+    if (c.size() == 2)
+        st.charPos = QPoint(c[0].toInt(), c[1].toInt());
+    st.state = o["state"].toString();
+    st.volume = o["volume"].toInt(st.volume);
+    st.frequency = o["frequency"].toInt(st.frequency);
+
+    for (const auto &v : o["items"].toArray())
+    {
+        const QJsonObject io = v.toObject();
+        WorldItemState it;
+        it.id = io["id"].toString();
+        const QJsonArray p = io["pos"].toArray();
+        if (p.size() == 2)
+            it.pos = QPoint(p[0].toInt(), p[1].toInt());
+        it.equipped = io["equipped"].toBool();
+        it.spawned = io["spawned"].toBool();
+        it.hp = io["hp"].toInt();
+        if (!it.id.isEmpty())
+            st.items.push_back(it);
+    }
+    return st;
+}
+
+JournalWriter::JournalWriter(const QString &dir)
+    : dirPath(dir)
+{
+}
+
+QString JournalWriter::journalPath() const
+{
+    return QDir(dirPath).filePath("journal.jsonl");
+}
+
+QString JournalWriter::snapshotPath() const
+{
+    return QDir(dirPath).filePath("snapshot.json");
+}
+
+void JournalWriter::append(const QByteArray &line)
+{
+    QDir().mkpath(dirPath);
+
+    QFile f(journalPath());
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qWarning() << "WorldStore: cannot open" << f.fileName();
+        return;
+    }
+    f.write(line);
+    f.write("\n");
+    f.flush();
+    f.close();
+
+    lastLine = line;
+    if (++entries >= WorldStore::compactEvery)
+        compact();
+}
+
+void JournalWriter::compact()
+{
+    // 每条 journal 都是完整状态：快照 = 最后一条。先原子写快照，再清空 journal
+    QSaveFile snap(snapshotPath());
+    if (!snap.open(QIODevice::WriteOnly))
+        return;
+    snap.write(lastLine);
+    if (!snap.commit())
+        return;
+
+    QFile::resize(journalPath(), 0);
+    entries = 0;
+}
+
+WorldState JournalWriter::load()
+{
+    QByteArray latest;
+
+    QFile snap(snapshotPath());
+    if (snap.open(QIODevice::ReadOnly))
+        latest = snap.readAll().trimmed();
+
+    QFile journal(journalPath());
+    if (journal.open(QIODevice::ReadOnly))
+    {
+        while (!journal.atEnd())
+        {
+            const QByteArray line = journal.readLine().trimmed();
+            if (line.isEmpty())
+                continue;
+            // 崩溃时最后一行可能只写了一半：解析失败就保留上一条
+            if (QJsonDocument::fromJson(line).isObject())
+            {
+                latest = line;
+                ++entries;
+            }
+        }
+    }
+
+    lastLine = latest;
+    const QJsonDocument doc = QJsonDocument::fromJson(latest);
+    if (!doc.isObject())
+        return WorldState();
+    return WorldState::fromJson(doc.object());
+}
+
+WorldStore::WorldStore(QObject *parent)
+    : QObject(parent)
+{
+    const QString dir = QDir(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)).filePath("expldy");
+
+    worker.setObjectName("WorldStore");
+    writer = new JournalWriter(dir);
+    writer->moveToThread(&worker);
+    connect(&worker, &QThread::finished, writer, &QObject::deleteLater);
+    worker.start(QThread::LowPriority);
+
+    // 不重启的单次计时：第一次变脏后 flushDelayMs 内必定落盘，连续拖动也不会被无限推迟
+    debounce.setSingleShot(true);
+    debounce.setInterval(flushDelayMs);
+    connect(&debounce, &QTimer::timeout, this, [this]()
+            { flushNow(); });
+}
+
+WorldStore::~WorldStore()
+{
+    // 队列按顺序执行：空任务返回时，之前排队的写入都已落盘
+    QMetaObject::invokeMethod(writer, []() {}, Qt::BlockingQueuedConnection);
+    worker.quit();
+    worker.wait();
+}
+
+void WorldStore::markDirty()
+{
+    if (!debounce.isActive())
+        debounce.start();
+}
+
+void WorldStore::flushNow()
+{
+    debounce.stop();
+    if (!capture)
+        return;
+
+    const QByteArray line = QJsonDocument(capture().toJson()).toJson(QJsonDocument::Compact);
+    JournalWriter *w = writer;
+    QMetaObject::invokeMethod(w, [w, line]()
+                              { w->append(line); }, Qt::QueuedConnection);
+}
+
+void WorldStore::loadAsync(std::function<void(const WorldState &)> done)
+{
+    JournalWriter *w = writer;
+    QMetaObject::invokeMethod(w, [this, w, done]()
+                              {
+        const WorldState st = w->load();
+        QMetaObject::invokeMethod(this, [done, st]()
+                                  { done(st); }, Qt::QueuedConnection); }, Qt::QueuedConnection);
+}
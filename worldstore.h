@@ -0,0 +1,84 @@
+#pragma once
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QString>
+#include <QVector>
+#include <QPoint>
+#include <QByteArray>
+#include <QJsonObject>
+#include <functional>
+
+// 场景里的一个物品（坐标为顶层窗口坐标）
+struct WorldItemState
+{
+    QString id;
+    QPoint pos;
+    bool equipped = false;
+    bool spawned = false;
+    int hp = 0;
+};
+
+// 整个桌宠世界的可持久化状态
+struct WorldState
+{
+    bool valid = false; // false：磁盘上没有任何存档
+    QPoint charPos;
+    QString state; // "idle" / "happy" / ...
+    int volume = 70;
+    int frequency = 50;
+    QVector<WorldItemState> items;
+
+    QJsonObject toJson() const;
+    static WorldState fromJson(const QJsonObject &o);
+};
+
+class JournalWriter;
+
+// WorldStore
+// - markDirty()：防抖（最多 flushDelayMs 后落盘一次），GUI 线程只负责抓状态+序列化一小段 JSON
+// - 写入在后台线程：journal.jsonl 追加一行并 flush，每 compactEvery 条压成 snapshot.json
+// - loadAsync()：后台线程读 snapshot + 回放 journal（最后一行可能被崩溃截断，丢弃即可）
+// 崩溃最多丢 flushDelayMs 的状态。
+class WorldStore : public QObject
+{
+public:
+    using Capture = std::function<WorldState()>;
+
+    explicit WorldStore(QObject *parent = nullptr);
+    ~WorldStore() override;
+
+    void setCapture(Capture fn) { capture = std::move(fn); }
+    void markDirty();
+    void flushNow();
+
+    void loadAsync(std::function<void(const WorldState &)> done);
+
+    static constexpr int flushDelayMs = 250;
+    static constexpr int compactEvery = 200;
+
+private:
+    QThread worker;
+    JournalWriter *writer = nullptr;
+    QTimer debounce;
+    Capture capture;
+};
+
+// 住在 WorldStore 的工作线程
+class JournalWriter : public QObject
+{
+public:
+    explicit JournalWriter(const QString &dir);
+
+    void append(const QByteArray &line);
+    WorldState load();
+
+private:
+    QString dirPath;
+    int entries = 0;
+    QByteArray lastLine;
+
+    QString journalPath() const;
+    QString snapshotPath() const;
+    void compact();
+};